@@ -1,25 +1,28 @@
 workspace 'stx'
 
 language   'C++'
-cppdialect 'C++17'
+cppdialect 'C++20'
 
 configurations {
 	'dev',
 	'debug',
 	'release',
+	'tracking', -- dev with STX_ALLOC_TRACKING, e.g. to run the allocation tracking tests
 }
 
-filter 'configurations:release or dev'
+filter 'configurations:release or dev or tracking'
 	optimize 'Speed'
-filter 'configurations:dev or debug'
+filter 'configurations:dev or debug or tracking'
 	symbols 'On'
+filter 'configurations:tracking'
+	defines 'STX_ALLOC_TRACKING=1'
 filter 'configurations:debug'
 	optimize 'Debug'
 filter 'configurations:release'
 	flags 'LinkTimeOptimization'
 filter {}
 
-filter { 'configurations:dev or debug', 'toolset:gcc or clang' }
+filter { 'configurations:dev or debug or tracking', 'toolset:gcc or clang' }
 	buildoptions { '-Wall', '-Wextra', '-Wno-unused-parameter' }
 filter {}
 
@@ -58,3 +61,21 @@ project 'test'
 	filter 'system:not windows'
 		links {'pthread'}
 	filter {}
+
+project 'bench'
+	kind 'ConsoleApp'
+	files 'test/bench/**'
+	defines 'CATCH_CONFIG_ENABLE_BENCHMARKING'
+	links 'stx'
+	filter 'system:not windows'
+		links {'pthread'}
+	filter {}
+
+-- Replaces the global operator new to count allocations, which would skew the other benchmarks
+project 'bench_allocations'
+	kind 'ConsoleApp'
+	files 'test/bench_allocations/**'
+	links 'stx'
+	filter 'system:not windows'
+		links {'pthread'}
+	filter {}
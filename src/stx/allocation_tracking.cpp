@@ -0,0 +1,70 @@
+#include "allocation_tracking.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+namespace stx {
+
+static
+std::atomic<allocation_tag*>& _registry() noexcept {
+	static std::atomic<allocation_tag*> head{nullptr};
+	return head;
+}
+
+allocation_tag::allocation_tag(std::string name) noexcept :
+	m_name(std::move(name)),
+	m_next(_registry().load(std::memory_order_relaxed))
+{
+	while(!_registry().compare_exchange_weak(m_next, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+allocation_stats allocation_tag::stats() const noexcept {
+	allocation_stats result;
+	result.name              = m_name;
+	result.live_bytes        = m_live_bytes.load(std::memory_order_relaxed);
+	result.peak_bytes        = m_peak_bytes.load(std::memory_order_relaxed);
+	result.live_allocations  = m_live_allocations.load(std::memory_order_relaxed);
+	result.total_allocations = m_total_allocations.load(std::memory_order_relaxed);
+	return result;
+}
+
+allocation_tag& allocation_tag_named(std::string const& name) noexcept {
+	static std::mutex                              mutex;
+	static std::map<std::string, allocation_tag*>* tags = new std::map<std::string, allocation_tag*>();
+
+	std::scoped_lock lock{mutex};
+	allocation_tag*& tag = (*tags)[name];
+	if(!tag) tag = new allocation_tag(name); // Never destroyed, like allocation_tag_of()
+	return *tag;
+}
+
+std::vector<allocation_stats> allocation_report() {
+	std::vector<allocation_stats> result;
+	for(allocation_tag* tag = _registry().load(std::memory_order_acquire); tag; tag = tag->_next()) {
+		result.push_back(tag->stats());
+	}
+
+	std::stable_sort(result.begin(), result.end(), [](auto& a, auto& b) { return a.live_bytes > b.live_bytes; });
+	return result;
+}
+
+void print_allocation_report(std::ostream& to) {
+	char line[64];
+	to << "  live bytes   peak bytes  live allocs total allocs  tag\n";
+	for(auto& stats : allocation_report()) {
+		std::snprintf(line, sizeof(line), "%12zu %12zu %12zu %12zu  ",
+			stats.live_bytes, stats.peak_bytes, stats.live_allocations, stats.total_allocations);
+		to << line << stats.name << '\n';
+	}
+}
+
+void reset_allocation_peaks() noexcept {
+	for(allocation_tag* tag = _registry().load(std::memory_order_acquire); tag; tag = tag->_next()) {
+		tag->reset_peak();
+	}
+}
+
+} // namespace stx
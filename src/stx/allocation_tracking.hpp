@@ -0,0 +1,103 @@
+#pragma once
+
+#include "type.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+// Set to 1 to account the memory of arena_allocator, make_shared and the object pools to tags.
+// Has to be the same in all translation units, including the library itself. Tags can be used for own allocations either way.
+#ifndef STX_ALLOC_TRACKING
+	#define STX_ALLOC_TRACKING 0
+#endif
+
+namespace stx {
+
+// =============================================================
+// == allocation_tag =============================================
+// =============================================================
+
+struct allocation_stats {
+	std::string name;
+	size_t      live_bytes        = 0;
+	size_t      peak_bytes        = 0; //<! Maximum of live_bytes since the last reset_allocation_peaks()
+	size_t      live_allocations  = 0;
+	size_t      total_allocations = 0;
+};
+
+/// Counters for one kind of allocation, e.g. one type or one subsystem.
+/// Tags register themselves in a global list on construction and have to live until the end of the program (Make them static).
+/// Counting only uses relaxed atomics, so allocations can be tracked from any thread.
+class allocation_tag {
+public:
+	explicit allocation_tag(std::string name) noexcept;
+
+	allocation_tag(allocation_tag const&) = delete;
+	allocation_tag& operator=(allocation_tag const&) = delete;
+
+	void on_alloc(size_t bytes) noexcept;
+	void on_free(size_t bytes) noexcept;
+
+	allocation_stats   stats() const noexcept;
+	void               reset_peak() noexcept { m_peak_bytes.store(m_live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+	std::string const& name()  const noexcept { return m_name; }
+
+	allocation_tag* _next() const noexcept { return m_next; }
+
+private:
+	std::string         m_name;
+	std::atomic<size_t> m_live_bytes{0};
+	std::atomic<size_t> m_peak_bytes{0};
+	std::atomic<size_t> m_live_allocations{0};
+	std::atomic<size_t> m_total_allocations{0};
+	allocation_tag*     m_next; //<! Registry
+};
+
+/// The tag named after T (via stx::demangle), e.g. used for make_shared<T>
+template<class T>
+allocation_tag& allocation_tag_of() noexcept;
+
+/// The tag with the given name, created on first use. Takes a lock, so cache the result.
+allocation_tag& allocation_tag_named(std::string const& name) noexcept;
+
+/// Stats of all tags, most live bytes first
+std::vector<allocation_stats> allocation_report();
+void print_allocation_report(std::ostream& to);
+void reset_allocation_peaks() noexcept;
+
+} // namespace stx
+
+// =============================================================
+// == Inline implementation =============================================
+// =============================================================
+
+namespace stx {
+
+inline
+void allocation_tag::on_alloc(size_t bytes) noexcept {
+	size_t live = m_live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	m_live_allocations.fetch_add(1, std::memory_order_relaxed);
+	m_total_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	size_t peak = m_peak_bytes.load(std::memory_order_relaxed);
+	while(live > peak && !m_peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+}
+
+inline
+void allocation_tag::on_free(size_t bytes) noexcept {
+	m_live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+	m_live_allocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template<class T>
+allocation_tag& allocation_tag_of() noexcept {
+	// Never destroyed: Objects might be freed during static destruction
+	static allocation_tag* tag = new allocation_tag(demangle(typeid(T).name()));
+	return *tag;
+}
+
+} // namespace stx
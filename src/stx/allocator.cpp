@@ -1,28 +1,62 @@
 #include "allocator.hpp"
+#include "allocation_tracking.hpp"
+
+#include <cstdint>
+#include <initializer_list>
 
 namespace stx {
 
+namespace {
+
+struct block_header {
+	char*  old;  //<! Next block in the list
+	size_t size; //<! Usable bytes
+};
+
+} // namespace
+
 static
 char*& _old_arena(char* arena) {
-	return *((char**) arena);
+	return reinterpret_cast<block_header*>(arena)->old;
 }
 
 static
-char* _create_arena(size_t size, char* old, char** top, char** end) {
-	char* result = new char[size + sizeof(char*)];
-	_old_arena(result) = old;
-	if(top != nullptr)
-		*top = result + sizeof(char*);
-	if(end != nullptr)
-		*end = *top + size;
+char* _data(char* arena) {
+	return arena + sizeof(block_header);
+}
+
+static
+void _track_alloc(allocation_tag* tag, size_t bytes) noexcept {
+#if STX_ALLOC_TRACKING
+	(tag ? *tag : allocation_tag_of<arena_allocator>()).on_alloc(bytes);
+#endif
+}
+static
+void _track_free(allocation_tag* tag, size_t bytes) noexcept {
+#if STX_ALLOC_TRACKING
+	(tag ? *tag : allocation_tag_of<arena_allocator>()).on_free(bytes);
+#endif
+}
+
+static
+char* _create_arena(size_t size, char* old, allocation_tag* tag) {
+	char* result = new char[size + sizeof(block_header)];
+	*reinterpret_cast<block_header*>(result) = { old, size };
+	_track_alloc(tag, size + sizeof(block_header));
 	return result;
 }
 
 static
-void _destroy_arena(char* arena) {
+void _delete_arena(char* arena, allocation_tag* tag) {
+	_track_free(tag, reinterpret_cast<block_header*>(arena)->size + sizeof(block_header));
+	delete[] arena;
+}
+
+static
+void _destroy_arena(char* arena, allocation_tag* tag) {
 	while(arena) {
 		char* old_arena = _old_arena(arena);
-		delete[] arena;
+		_delete_arena(arena, tag);
 		arena = old_arena;
 	}
 }
@@ -31,49 +65,127 @@ arena_allocator::arena_allocator(size_t block_size) noexcept :
 	m_arena_size(block_size),
 	m_arena(nullptr),
 	m_top(nullptr),
-	m_arena_end(nullptr)
+	m_arena_end(nullptr),
+	m_free(nullptr),
+	m_large(nullptr),
+	m_tag(nullptr)
 {}
 
 arena_allocator::~arena_allocator() noexcept {
-	reset();
+	release();
 }
 
-arena_allocator::arena_allocator(arena_allocator&& other) noexcept {
-	m_arena = other.m_arena; other.m_arena = nullptr;
-	m_top = other.m_top; other.m_top = nullptr;
-	m_arena_end = other.m_arena_end; other.m_arena_end = nullptr;
-	m_arena_size = other.m_arena_size;
-}
+arena_allocator::arena_allocator(arena_allocator&& other) noexcept :
+	m_arena_size(other.m_arena_size),
+	m_arena(std::exchange(other.m_arena, nullptr)),
+	m_top(std::exchange(other.m_top, nullptr)),
+	m_arena_end(std::exchange(other.m_arena_end, nullptr)),
+	m_free(std::exchange(other.m_free, nullptr)),
+	m_large(std::exchange(other.m_large, nullptr)),
+	m_tag(other.m_tag)
+{}
 arena_allocator& arena_allocator::operator=(arena_allocator&& other) noexcept {
-	m_arena = other.m_arena; other.m_arena = nullptr;
-	m_top = other.m_top; other.m_top = nullptr;
-	m_arena_end = other.m_arena_end; other.m_arena_end = nullptr;
-	m_arena_size = other.m_arena_size;
+	if(this != &other) {
+		release();
+		m_arena_size = other.m_arena_size;
+		m_arena      = std::exchange(other.m_arena, nullptr);
+		m_top        = std::exchange(other.m_top, nullptr);
+		m_arena_end  = std::exchange(other.m_arena_end, nullptr);
+		m_free       = std::exchange(other.m_free, nullptr);
+		m_large      = std::exchange(other.m_large, nullptr);
+		m_tag        = other.m_tag;
+	}
 	return *this;
 }
 
 void arena_allocator::reset() noexcept {
-	_destroy_arena(m_arena);
-	m_arena = m_top = m_arena_end = nullptr;
+	rewind({ nullptr, nullptr, nullptr });
+}
+void arena_allocator::release() noexcept {
+	reset();
+	_destroy_arena(m_free, m_tag);
+	m_free = nullptr;
 }
 
-char* arena_allocator::alloc(size_t bytes) noexcept {
-	char* new_top = m_top + bytes;
+void arena_allocator::rewind(marker m) noexcept {
+	// Big allocations have their own blocks
+	while(m_large != m.large) {
+		char* old_large = _old_arena(m_large);
+		_delete_arena(m_large, m_tag);
+		m_large = old_large;
+	}
 
-	if(new_top > m_arena_end) {
-		if(bytes > m_arena_size) {
-			// Bigger than our usual arena size:
-			//  Create a new arena just for this allocation, and append it between the current one and its predecessor
-			return _old_arena(m_arena) = _create_arena(bytes, _old_arena(m_arena), nullptr, nullptr);
-		}
-		else {
-			m_arena = _create_arena(m_arena_size, m_arena, &m_top, &m_arena_end);
-			new_top = m_top + bytes;
+	// Keep all blocks after the marker for reuse
+	while(m_arena != m.arena) {
+		char* old_arena = _old_arena(m_arena);
+		_old_arena(m_arena) = m_free;
+		m_free  = m_arena;
+		m_arena = old_arena;
+	}
+
+	m_top       = m.top;
+	m_arena_end = m_arena ? _data(m_arena) + m_arena_size : nullptr;
+}
+
+void arena_allocator::adopt(arena_allocator&& other) noexcept {
+	if(this == &other) return;
+
+	// other's blocks might have a different size, so they join the big allocations, which are never reused
+	for(char** list : { &other.m_arena, &other.m_large }) {
+		while(char* block = *list) {
+			*list = _old_arena(block);
+			if(other.m_tag != m_tag) {
+				size_t bytes = reinterpret_cast<block_header*>(block)->size + sizeof(block_header);
+				_track_free(other.m_tag, bytes);
+				_track_alloc(m_tag, bytes);
+			}
+			_old_arena(block) = m_large;
+			m_large = block;
 		}
 	}
+	other.m_top       = nullptr;
+	other.m_arena_end = nullptr;
+	other.release();
+}
+
+void arena_allocator::next_block() noexcept {
+	char* block;
+	if(m_free) {
+		block  = m_free;
+		m_free = _old_arena(m_free);
+		_old_arena(block) = m_arena;
+	}
+	else {
+		block = _create_arena(m_arena_size, m_arena, m_tag);
+	}
+
+	m_arena     = block;
+	m_top       = _data(block);
+	m_arena_end = m_top + m_arena_size;
+}
+
+static
+char* _align_up(char* p, size_t alignment) noexcept {
+	return (char*) ((uintptr_t(p) + (alignment - 1)) & ~uintptr_t(alignment - 1));
+}
+
+char* arena_allocator::alloc(size_t bytes, size_t alignment) noexcept {
+	// Worst case padding, so the decision doesn't depend on where m_top currently is (undo_alloc() relies on that)
+	size_t padded = bytes + (alignment - 1);
 
-	char* result = m_top;
-	m_top = new_top;
+	if(padded > m_arena_size) {
+		// Bigger than our usual arena size: Create a block just for this allocation
+		m_large = _create_arena(padded, m_large, m_tag);
+		return _align_up(_data(m_large), alignment);
+	}
+
+	char* result = _align_up(m_top, alignment);
+	if(!m_top || size_t(result - m_top) + bytes > size_t(m_arena_end - m_top)) {
+		next_block();
+		result = _align_up(m_top, alignment);
+	}
+
+	m_top = result + bytes;
 	return result;
 }
 
@@ -83,8 +195,129 @@ char* arena_allocator::alloc_string(size_t n) noexcept {
 	return result;
 }
 
-void arena_allocator::undo_alloc(size_t bytes) noexcept {
-	// TODO: arena_allocator::undo_alloc
+void arena_allocator::undo_alloc(size_t bytes, size_t alignment) noexcept {
+	if(bytes + (alignment - 1) > m_arena_size) {
+		if(m_large) {
+			char* old_large = _old_arena(m_large);
+			_delete_arena(m_large, m_tag);
+			m_large = old_large;
+		}
+	}
+	else if(m_arena && size_t(m_top - _data(m_arena)) >= bytes) {
+		m_top -= bytes;
+	}
+}
+
+bool arena_allocator::free_if_last(char* p, size_t bytes) noexcept {
+	// Big allocations might be referenced by a marker, so they are only freed by reset() and rewind()
+	if(m_arena && p + bytes == m_top && p >= _data(m_arena)) {
+		m_top = p;
+		return true;
+	}
+	return false;
+}
+
+arena_allocator& thread_arena() noexcept {
+	static thread_local arena_allocator arena;
+	return arena;
+}
+
+// =============================================================
+// == ring_allocator =============================================
+// =============================================================
+
+ring_allocator::ring_allocator(size_t capacity, unsigned frames_in_flight) noexcept :
+	m_buffer(new char[capacity]),
+	m_capacity(capacity),
+	m_head(0),
+	m_used(0),
+	m_high_water_mark(0),
+	m_peak_frame_bytes(0),
+	m_overflows(0),
+	m_frames(frames_in_flight > 0 ? frames_in_flight : 1, frame { 0, 0 }),
+	m_current(0)
+{}
+
+ring_allocator::~ring_allocator() noexcept {
+	delete[] m_buffer;
+}
+
+char* ring_allocator::alloc(size_t bytes, size_t alignment) noexcept {
+	// The oldest frame in flight starts where free space ends
+	size_t tail  = m_frames[(m_current + 1) % m_frames.size()].begin;
+	size_t start = size_t(_align_up(m_buffer + m_head, alignment) - m_buffer);
+	size_t limit = m_head >= tail ? m_capacity : tail;
+
+	if(m_used > 0 && m_head == tail) {
+		limit = m_head; // Completely full
+	}
+	else if(m_head >= tail && (start > m_capacity || bytes > m_capacity - start)) {
+		// Doesn't fit in front of the end: Wrap around, skipping the rest of the buffer
+		start = size_t(_align_up(m_buffer, alignment) - m_buffer);
+		limit = tail;
+	}
+
+	if(start > limit || bytes > limit - start) {
+		m_overflows++;
+		return nullptr;
+	}
+
+	size_t consumed = start >= m_head ? start + bytes - m_head : (m_capacity - m_head) + start + bytes;
+	m_head = start + bytes;
+
+	frame& current = m_frames[m_current];
+	current.bytes += consumed;
+	m_used        += consumed;
+
+	if(m_used > m_high_water_mark)          m_high_water_mark  = m_used;
+	if(current.bytes > m_peak_frame_bytes) m_peak_frame_bytes = current.bytes;
+
+	return m_buffer + start;
+}
+
+void ring_allocator::next_frame() noexcept {
+	m_current = (m_current + 1) % m_frames.size();
+
+	// Retire the oldest frame, which makes room for the new one
+	frame& retired = m_frames[m_current];
+	m_used -= retired.bytes;
+	retired = { m_head, 0 };
+}
+
+ring_allocator::statistics ring_allocator::stats() const noexcept {
+	statistics result;
+	result.capacity         = m_capacity;
+	result.used             = m_used;
+	result.high_water_mark  = m_high_water_mark;
+	result.frame_bytes      = m_frames[m_current].bytes;
+	result.peak_frame_bytes = m_peak_frame_bytes;
+	result.overflows        = m_overflows;
+	return result;
+}
+
+void ring_allocator::reset_stats() noexcept {
+	m_high_water_mark  = m_used;
+	m_peak_frame_bytes = m_frames[m_current].bytes;
+	m_overflows        = 0;
+}
+
+// =============================================================
+// == arena_memory_resource =============================================
+// =============================================================
+
+#if __has_include(<memory_resource>)
+
+void* arena_memory_resource::do_allocate(size_t bytes, size_t alignment) {
+	return m_arena.alloc(bytes, alignment);
+}
+void arena_memory_resource::do_deallocate(void* p, size_t bytes, size_t) {
+	m_arena.free_if_last(static_cast<char*>(p), bytes);
 }
+bool arena_memory_resource::do_is_equal(std::pmr::memory_resource const& other) const noexcept {
+	auto* o = dynamic_cast<arena_memory_resource const*>(&other);
+	return o && &o->m_arena == &m_arena;
+}
+
+#endif // __has_include(<memory_resource>)
 
 } // namespace stx
@@ -1,37 +1,205 @@
 // Copyright (c) 2017 Benno Straub, licensed under the MIT license. (A copy can be found at the end of this file)
 
-// Warning: These aren't allocators in the STL sense
+// Warning: arena_allocator isn't an allocator in the STL sense, use arena_stl_allocator or arena_memory_resource for containers
+
+#pragma once
 
 #include <cstddef>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
 
 namespace stx {
 
+class allocation_tag;
+
+/// Hands out memory by bumping a pointer through blocks of block_size bytes, everything is freed at once.
+/// Blocks are kept across reset() and rewind(), so a reused arena stops calling new[] entirely.
+/// Allocations bigger than block_size get a block of their own, which is freed again by reset() and rewind().
 class arena_allocator {
 public:
-	arena_allocator(size_t block_size = 4096 - sizeof(char*)) noexcept;
+	/// A position in the arena, see mark() and rewind()
+	struct marker {
+		char* arena;
+		char* top;
+		char* large;
+	};
+
+	arena_allocator(size_t block_size = 4096 - 2 * sizeof(char*)) noexcept;
 	~arena_allocator() noexcept;
 
 	arena_allocator(arena_allocator&& other) noexcept;
 	arena_allocator& operator=(arena_allocator&& other) noexcept;
 
-	char* alloc(size_t bytes) noexcept;
+	/// alignment has to be a power of two. The default of 1 packs allocations tightly, e.g. for strings.
+	char* alloc(size_t bytes, size_t alignment = 1) noexcept;
 	char* alloc_string(size_t n) noexcept;
-	void  reset() noexcept;
+	void  reset() noexcept;   //<! Frees all allocations, but keeps the blocks for reuse
+	void  release() noexcept; //<! Frees all allocations and gives all blocks back to the system
+
+	/// Gives back the last allocation of bytes bytes (Has to be the last one, e.g. after a constructor threw)
+	void undo_alloc(size_t bytes, size_t alignment = 1) noexcept;
+	/// Gives back p if it's the most recent allocation within a block, otherwise the memory stays in use until reset()
+	bool free_if_last(char* p, size_t bytes) noexcept;
+
+	/// Takes over all allocations of other, which stay valid until this arena frees them, e.g. to merge arenas filled on other threads.
+	/// They count as allocated now, so they are freed by rewinding to a marker taken before. other is left empty.
+	void adopt(arena_allocator&& other) noexcept;
+
+	marker mark() const noexcept { return { m_arena, m_top, m_large }; }
+	void   rewind(marker m) noexcept; //<! Frees everything allocated after m was taken
+
+	size_t block_size() const noexcept { return m_arena_size; }
 
-	void undo_alloc(size_t bytes) noexcept;
+	/// Accounts this arena's blocks to tag instead of the stx::arena_allocator tag (Only with STX_ALLOC_TRACKING, see allocation_tracking.hpp).
+	/// Has to be set before the first allocation.
+	void track_as(allocation_tag& tag) noexcept { m_tag = &tag; }
 
 	template<class T, class... Args>
-	T* create(Args... args);
+	T* create(Args... args); //<! Aligned for T
+
+private:
+	void next_block() noexcept;
+
+	size_t          m_arena_size;
+	char*           m_arena;     //<! Current block, linked to the blocks before it
+	char*           m_top;
+	char*           m_arena_end;
+	char*           m_free;      //<! Retained blocks
+	char*           m_large;     //<! Blocks of allocations bigger than m_arena_size, most recent first
+	allocation_tag* m_tag;       //<! nullptr: The stx::arena_allocator tag
+};
+
+/// Rewinds an arena to where it was on construction
+class arena_scope {
+public:
+	arena_scope(arena_allocator& arena) noexcept : m_arena(arena), m_marker(arena.mark()) {}
+	~arena_scope() noexcept { m_arena.rewind(m_marker); }
+
+	arena_scope(arena_scope const&) = delete;
+	arena_scope& operator=(arena_scope const&) = delete;
+
+private:
+	arena_allocator&        m_arena;
+	arena_allocator::marker m_marker;
+};
+
+/// An arena owned by the calling thread, e.g. for scratch memory in tasks. Use with arena_scope.
+arena_allocator& thread_arena() noexcept;
+
+// =============================================================
+// == Adapters =============================================
+// =============================================================
+
+/// Lets standard containers allocate from an arena, e.g. std::vector<int, arena_stl_allocator<int>>.
+/// deallocate() only gives memory back if it was the last allocation, everything else is freed with the arena.
+/// Like the arena itself, not thread safe.
+template<class T>
+class arena_stl_allocator {
+public:
+	using value_type = T;
+
+	arena_stl_allocator(arena_allocator& arena) noexcept : m_arena(&arena) {}
+	template<class U>
+	arena_stl_allocator(arena_stl_allocator<U> const& other) noexcept : m_arena(&other.arena()) {}
+
+	T*   allocate(size_t n);
+	void deallocate(T* p, size_t n) noexcept;
+
+	arena_allocator& arena() const noexcept { return *m_arena; }
+
+	template<class U>
+	bool operator==(arena_stl_allocator<U> const& other) const noexcept { return m_arena == &other.arena(); }
+	template<class U>
+	bool operator!=(arena_stl_allocator<U> const& other) const noexcept { return m_arena != &other.arena(); }
+
+private:
+	arena_allocator* m_arena;
+};
+
+#if __has_include(<memory_resource>)
+
+/// Lets std::pmr containers allocate from an arena, which also works for nested containers (e.g. std::pmr::vector<std::pmr::string>).
+/// Has the same deallocation behavior as arena_stl_allocator. Not thread safe.
+class arena_memory_resource : public std::pmr::memory_resource {
+public:
+	arena_memory_resource(arena_allocator& arena) noexcept : m_arena(arena) {}
+
+	arena_allocator& arena() const noexcept { return m_arena; }
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void  do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool  do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
 
 private:
-	size_t m_arena_size;
-	char*  m_arena;
-	char*  m_top;
-	char*  m_arena_end;
+	arena_allocator& m_arena;
 };
 
-// TODO: implement ring_allocator
+#endif // __has_include(<memory_resource>)
+
+// =============================================================
+// == ring_allocator =============================================
+// =============================================================
+
+/// Hands out transient memory from a fixed size ring buffer, for data that lives a bounded number of frames.
+/// Everything allocated during a frame is retired at once when frames_in_flight more frames have begun, in O(1).
+/// Running into memory of a frame that's still alive is an overflow: alloc() returns nullptr and the overflow is counted.
+/// Like arena_allocator, not thread safe.
+class ring_allocator {
+public:
+	struct statistics {
+		size_t capacity;
+		size_t used;             //<! Bytes held by all frames in flight, including padding
+		size_t high_water_mark;  //<! Maximum of used
+		size_t frame_bytes;      //<! Bytes allocated during the current frame
+		size_t peak_frame_bytes; //<! Maximum of frame_bytes
+		size_t overflows;        //<! Number of failed allocations
+	};
+
+	ring_allocator(size_t capacity, unsigned frames_in_flight = 2) noexcept;
+	~ring_allocator() noexcept;
+
+	ring_allocator(ring_allocator const&) = delete;
+	ring_allocator& operator=(ring_allocator const&) = delete;
+
+	/// nullptr on overflow. alignment has to be a power of two.
+	char* alloc(size_t bytes, size_t alignment = alignof(std::max_align_t)) noexcept;
+
+	template<class T, class... Args>
+	T* create(Args&&... args); //<! nullptr on overflow. Destructors are never run, so T has to be trivially destructible.
+
+	/// Begins the next frame, retiring everything allocated frames_in_flight frames ago
+	void next_frame() noexcept;
+
+	statistics stats() const noexcept;
+	void       reset_stats() noexcept; //<! Resets high_water_mark, peak_frame_bytes and overflows
+
+	size_t capacity()  const noexcept { return m_capacity; }
+	size_t used()      const noexcept { return m_used; }
+	bool   overflowed() const noexcept { return m_overflows > 0; }
+
+private:
+	struct frame {
+		size_t begin; //<! Offset of the frame's first allocation
+		size_t bytes; //<! Including alignment padding and space skipped when wrapping around
+	};
+
+	char*              m_buffer;
+	size_t             m_capacity;
+	size_t             m_head;    //<! Offset of the next allocation
+	size_t             m_used;
+	size_t             m_high_water_mark;
+	size_t             m_peak_frame_bytes;
+	size_t             m_overflows;
+	std::vector<frame> m_frames;  //<! One per frame in flight, used as ring
+	size_t             m_current; //<! Index of the current frame in m_frames
+};
 
 } // namespace stx
 
@@ -44,14 +212,37 @@ namespace stx {
 template<class T, class... Args>
 T* arena_allocator::create(Args... args) {
 	try {
-		return new(alloc(sizeof(T))) T(std::forward<Args>(args)...);
+		return new(alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
 	}
 	catch(...) {
-		undo_alloc(sizeof(T));
+		undo_alloc(sizeof(T), alignof(T));
 		throw;
 	}
 }
 
+// ** ring_allocator *******************************************************
+
+template<class T, class... Args>
+T* ring_allocator::create(Args&&... args) {
+	static_assert(std::is_trivially_destructible_v<T>, "ring_allocator never runs destructors");
+
+	char* p = alloc(sizeof(T), alignof(T));
+	if(!p) return nullptr;
+	return new(p) T(std::forward<Args>(args)...);
+}
+
+// ** arena_stl_allocator *******************************************************
+
+template<class T>
+T* arena_stl_allocator<T>::allocate(size_t n) {
+	if(n > size_t(-1) / sizeof(T)) throw std::bad_array_new_length();
+	return reinterpret_cast<T*>(m_arena->alloc(n * sizeof(T), alignof(T)));
+}
+template<class T>
+void arena_stl_allocator<T>::deallocate(T* p, size_t n) noexcept {
+	m_arena->free_if_last(reinterpret_cast<char*>(p), n * sizeof(T));
+}
+
 } // namespace stx
 
 /*
@@ -1,8 +1,7 @@
 #pragma once
 
-#include <functional>
-
 #include "shared.hpp"
+#include "async/task.hpp"
 
 namespace stx {
 
@@ -10,15 +9,21 @@ namespace stx {
 template<class T> class weak;
 
 // ** Executor *******************************************************
-// TODO: promises
+// See async/future.hpp for futures and promises, async/task_group.hpp for task groups and cancellation
 class executor {
 public:
 	inline virtual ~executor() {}
 
-	inline virtual void defer(std::function<void()> fn, float priority = 0) noexcept { (void)priority; fn(); }
+	inline virtual void defer(task fn, float priority = 0) noexcept { (void)priority; fn(); }
+
+	/// Number of threads running the deferred tasks, e.g. to split work across (See async/parallel.hpp).
+	/// 0 for executors which run tasks on the thread that defers them or pumps them (Like this one, or task_queue).
+	inline virtual size_t num_threads() noexcept { return 0; }
 
-	template<class Callback, class T>
-	void defer(Callback&& callback, weak<T> context, float priority) noexcept;
+	/// Runs callback only if guard.lock() is truthy once the task starts, keeping the result of lock() alive while it runs.
+	/// Guards are e.g. weak<T> (Skipped once the object died) or cancellation_token (See async/task_group.hpp).
+	template<class Callback, class Guard, class = decltype(bool(std::declval<Guard const&>().lock()))>
+	void defer(Callback&& callback, Guard guard, float priority) noexcept;
 
 	template<class... Args> inline
 	void operator()(Args&&... args) noexcept { defer(std::forward<Args>(args)...); }
@@ -55,11 +60,11 @@ auto assignTo(T& output, stx::weak<Context> if_this_still_exists) {
 
 namespace stx {
 
-template<class Callback, class T>
-void executor::defer(Callback&& callback, weak<T> context, float priority) noexcept {
+template<class Callback, class Guard, class>
+void executor::defer(Callback&& callback, Guard guard, float priority) noexcept {
 	defer(
-		[cb = std::move(callback), ctxt = std::move(context)]() {
-			if(auto tmp = ctxt.lock()) {
+		[cb = std::forward<Callback>(callback), guard = std::move(guard)]() mutable {
+			if(auto tmp = guard.lock()) {
 				cb();
 			}
 		},
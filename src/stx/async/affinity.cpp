@@ -0,0 +1,122 @@
+#include "affinity.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#ifdef __linux__
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+namespace stx {
+
+void apply_thread_options(thread_options const& options, unsigned index) noexcept {
+	if(!options.name.empty()) {
+		name_current_thread(options.name + "-" + std::to_string(index));
+	}
+	if(!options.cpus.empty()) {
+		if(options.one_cpu_each)
+			pin_current_thread({ options.cpus[index % options.cpus.size()] });
+		else
+			pin_current_thread(options.cpus);
+	}
+}
+
+bool name_current_thread(std::string_view name) noexcept {
+#ifdef __linux__
+	char buffer[16]; // Linux limits thread names to 15 characters + NUL
+	size_t length = name.copy(buffer, sizeof(buffer) - 1);
+	buffer[length] = '\0';
+	return pthread_setname_np(pthread_self(), buffer) == 0;
+#else
+	(void) name;
+	return false;
+#endif
+}
+
+bool pin_current_thread(cpu_set const& cpus) noexcept {
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for(int cpu : cpus) {
+		if(cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+	}
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	(void) cpus;
+	return false;
+#endif
+}
+
+int current_cpu() noexcept {
+#ifdef __linux__
+	return sched_getcpu();
+#else
+	return -1;
+#endif
+}
+
+cpu_set parse_cpu_list(std::string_view list) noexcept {
+	cpu_set result;
+
+	auto parse_int = [&](size_t& pos) {
+		int value = 0;
+		while(pos < list.size() && list[pos] >= '0' && list[pos] <= '9') {
+			value = value * 10 + (list[pos++] - '0');
+		}
+		return value;
+	};
+
+	size_t pos = 0;
+	while(pos < list.size()) {
+		if(list[pos] < '0' || list[pos] > '9') { pos++; continue; } // Separators, whitespace, newline
+
+		int first = parse_int(pos);
+		int last  = first;
+		if(pos < list.size() && list[pos] == '-') {
+			pos++;
+			last = parse_int(pos);
+		}
+		for(int cpu = first; cpu <= last; cpu++) {
+			result.push_back(cpu);
+		}
+	}
+
+	return result;
+}
+
+static
+bool _read_cpu_list(const char* path, cpu_set& result) noexcept {
+	std::ifstream file(path);
+	std::string   line;
+	if(!file || !std::getline(file, line)) return false;
+	result = parse_cpu_list(line);
+	return true;
+}
+
+std::vector<cpu_set> numa_nodes() noexcept {
+	std::vector<cpu_set> result;
+
+	cpu_set online;
+	if(_read_cpu_list("/sys/devices/system/node/online", online)) {
+		for(int node : online) {
+			cpu_set cpus;
+			std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+			if(_read_cpu_list(path.c_str(), cpus) && !cpus.empty()) {
+				result.push_back(std::move(cpus));
+			}
+		}
+	}
+
+	if(result.empty()) {
+		cpu_set all;
+		unsigned count = std::max(1u, std::thread::hardware_concurrency());
+		for(unsigned i = 0; i < count; i++) all.push_back(int(i));
+		result.push_back(std::move(all));
+	}
+
+	return result;
+}
+
+} // namespace stx
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stx {
+
+using cpu_set = std::vector<int>; //<! A list of CPU indices
+
+/// How the worker threads of a pool are set up
+struct thread_options {
+	std::string name;                 //<! Workers are named "<name>-<index>" (Truncated to 15 characters on Linux), empty: unnamed
+	cpu_set     cpus;                 //<! CPUs the workers may run on, empty: no pinning
+	bool        one_cpu_each = false; //<! Pin worker i to cpus[i % cpus.size()] instead of the whole set
+};
+
+/// Applies name and pinning of options to the calling thread, which is worker number index
+void apply_thread_options(thread_options const& options, unsigned index) noexcept;
+
+bool name_current_thread(std::string_view name) noexcept; //<! pthread_setname_np(), returns false if not supported
+bool pin_current_thread(cpu_set const& cpus) noexcept;    //<! pthread_setaffinity_np(), returns false if not supported
+int  current_cpu() noexcept;                              //<! sched_getcpu(), -1 if not supported
+
+/// Parses Linux cpu lists, e.g. "0-3,8,10-11"
+cpu_set parse_cpu_list(std::string_view list) noexcept;
+
+/// The CPUs of every NUMA node (From /sys/devices/system/node).
+/// Machines without NUMA information are reported as a single node containing all CPUs.
+std::vector<cpu_set> numa_nodes() noexcept;
+
+} // namespace stx
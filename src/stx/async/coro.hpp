@@ -0,0 +1,217 @@
+#pragma once
+
+#include "future.hpp"
+#include "socket_reactor.hpp"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#define STX_HAS_COROUTINES 1
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace stx {
+
+// =============================================================
+// == Forward declarations =============================================
+// =============================================================
+
+template<class T = void> class coro_task; //<! A lazily started coroutine, which can be co_await-ed or started as a future
+
+namespace detail {
+
+// =============================================================
+// == coro_promise =============================================
+// =============================================================
+
+template<class T>
+class coro_promise_base {
+public:
+	struct final_awaiter {
+		bool await_ready() const noexcept { return false; }
+
+		template<class Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+			auto& p = h.promise();
+			if(p.m_result) {
+				// Started detached via coro_task::start(): Publish the result and clean up after ourselves
+				stx::promise<T> result = std::move(*p.m_result);
+				std::exception_ptr error = p.m_error;
+				std::optional<future_storage_t<T>> value = std::move(p.m_value);
+				h.destroy();
+				if(error)
+					result.set_error(error);
+				else
+					result.set_value(std::move(*value));
+				return std::noop_coroutine();
+			}
+			return p.m_continuation ? p.m_continuation : std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	final_awaiter       final_suspend()   const noexcept { return {}; }
+
+	void unhandled_exception() noexcept { m_error = std::current_exception(); }
+
+	T result() {
+		if(m_error) std::rethrow_exception(m_error);
+		if constexpr(std::is_void_v<T>)
+			return;
+		else
+			return std::move(*m_value);
+	}
+
+	std::coroutine_handle<>              m_continuation; //<! Resumed once this coroutine finished
+	std::optional<stx::promise<T>>       m_result;       //<! Set if the coroutine was started detached
+	std::optional<future_storage_t<T>>   m_value;
+	std::exception_ptr                   m_error;
+};
+
+template<class T>
+class coro_promise : public coro_promise_base<T> {
+public:
+	coro_task<T> get_return_object() noexcept;
+
+	template<class U>
+	void return_value(U&& value) { this->m_value.emplace(std::forward<U>(value)); }
+};
+
+template<>
+class coro_promise<void> : public coro_promise_base<void> {
+public:
+	coro_task<void> get_return_object() noexcept;
+
+	void return_void() noexcept { this->m_value.emplace(); }
+};
+
+} // namespace detail
+
+// =============================================================
+// == coro_task<T> =============================================
+// =============================================================
+
+template<class T>
+class [[nodiscard]] coro_task {
+public:
+	using promise_type = detail::coro_promise<T>;
+	using handle_t     = std::coroutine_handle<promise_type>;
+
+	explicit coro_task(handle_t h) noexcept : m_handle(h) {}
+	~coro_task() noexcept { if(m_handle) m_handle.destroy(); }
+
+	coro_task(coro_task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+	coro_task& operator=(coro_task&& other) noexcept {
+		if(m_handle) m_handle.destroy();
+		m_handle = std::exchange(other.m_handle, nullptr);
+		return *this;
+	}
+
+	coro_task(coro_task const&) = delete;
+	coro_task& operator=(coro_task const&) = delete;
+
+	/// Starts the coroutine and resumes the awaiting coroutine once it finished (symmetric transfer, no allocations)
+	auto operator co_await() && noexcept {
+		struct awaiter {
+			handle_t h;
+
+			bool await_ready() const noexcept { return false; }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+				h.promise().m_continuation = awaiting;
+				return h;
+			}
+			T await_resume() { return h.promise().result(); }
+		};
+		return awaiter{m_handle};
+	}
+
+	/// Starts the coroutine on the current thread without anyone awaiting it.
+	/// The coroutine frame destroys itself when done, the result is published to the returned future.
+	future<T> start() && {
+		handle_t h = std::exchange(m_handle, nullptr);
+		future<T> result = h.promise().m_result.emplace().get_future();
+		h.resume();
+		return result;
+	}
+
+	/// Starts the coroutine and blocks until it finished
+	T get() && { return std::move(*this).start().get(); }
+
+private:
+	handle_t m_handle;
+};
+
+namespace detail {
+
+template<class T>
+coro_task<T> coro_promise<T>::get_return_object() noexcept {
+	return coro_task<T>(std::coroutine_handle<coro_promise<T>>::from_promise(*this));
+}
+inline
+coro_task<void> coro_promise<void>::get_return_object() noexcept {
+	return coro_task<void>(std::coroutine_handle<coro_promise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+// =============================================================
+// == Awaitables =============================================
+// =============================================================
+
+/// co_await stx::schedule(executor): Resume the coroutine as a task on the executor
+struct schedule_awaiter {
+	executor& e;
+	float     priority;
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> h) noexcept { e.defer([h]() { h.resume(); }, priority); }
+	void await_resume() const noexcept {}
+};
+
+inline schedule_awaiter schedule(executor& e, float priority = 0) noexcept { return {e, priority}; }
+inline schedule_awaiter operator co_await(executor& e) noexcept { return schedule(e); }
+
+/// co_await future: Resume the coroutine on the thread that fulfills the future (or continue if it's already ready)
+template<class T>
+auto operator co_await(future<T>&& f) noexcept {
+	struct awaiter {
+		future<T> f;
+
+		bool await_ready() const noexcept { return f.ready(); }
+		void await_suspend(std::coroutine_handle<> h) { f._state()->on_ready([h]() { h.resume(); }); }
+		T await_resume() { return f.get(); }
+	};
+	return awaiter{std::move(f)};
+}
+
+#ifdef STX_LINUX_SOCKETS
+
+/// co_await stx::readable(socket): Resume the coroutine on an executor once the socket has data (or was closed)
+struct socket_awaiter {
+	int                       handle;
+	socket_reactor::readiness readiness;
+	executor&                 resume_on;
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> h) noexcept {
+		global_socket_reactor().watch(handle, readiness, [h]() { h.resume(); }, resume_on);
+	}
+	void await_resume() const noexcept {}
+};
+
+inline socket_awaiter readable(socket& s, executor& resume_on = global_io_thread()) noexcept {
+	return {s.handle(), socket_reactor::readable, resume_on};
+}
+inline socket_awaiter writable(socket& s, executor& resume_on = global_io_thread()) noexcept {
+	return {s.handle(), socket_reactor::writable, resume_on};
+}
+
+#endif // STX_LINUX_SOCKETS
+
+} // namespace stx
+
+#endif // defined(__cpp_impl_coroutine)
@@ -0,0 +1,486 @@
+#pragma once
+
+#include "../async.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace stx {
+
+// =============================================================
+// == Forward declarations =============================================
+// =============================================================
+
+template<class T> class future; //<! The result of an asynchronous operation, which can be chained with then() and fail()
+template<class T> class promise; //<! The writing end of a future
+
+namespace detail {
+
+struct unit {}; //<! Stand-in for void values
+
+template<class T>
+using future_storage_t = std::conditional_t<std::is_void_v<T>, unit, T>;
+
+template<class T> struct is_future : std::false_type {};
+template<class T> struct is_future<future<T>> : std::true_type {};
+
+template<class T> struct unwrap_future { using type = T; };
+template<class T> struct unwrap_future<future<T>> { using type = T; };
+
+template<class T, class Fn, bool = std::is_void_v<T>>
+struct continuation_result { using type = std::invoke_result_t<Fn>; };
+template<class T, class Fn>
+struct continuation_result<T, Fn, false> { using type = std::invoke_result_t<Fn, T>; };
+
+template<class T, class Fn>
+using continuation_result_t = typename continuation_result<T, Fn>::type;
+
+// =============================================================
+// == future_state =============================================
+// =============================================================
+
+template<class T>
+class future_state {
+public:
+	using value_t = future_storage_t<T>;
+
+	void set_value(value_t v) { complete([&]() { m_value.emplace(std::move(v)); }); }
+	void set_error(std::exception_ptr e) { complete([&]() { m_error = std::move(e); }); }
+
+	bool ready() const noexcept {
+		std::scoped_lock lock{m_mutex};
+		return m_ready;
+	}
+
+	void wait() const noexcept {
+		std::unique_lock lock{m_mutex};
+		m_ready_cv.wait(lock, [this]() { return m_ready; });
+	}
+
+	/// Executes the continuation once a value or error was set (immediately, if this already happened)
+	/// Only one continuation is supported.
+	void on_ready(stx::task continuation) {
+		{ std::scoped_lock lock{m_mutex};
+			if(!m_ready) {
+				m_continuation = std::move(continuation);
+				return;
+			}
+		}
+		continuation();
+	}
+
+	// Only valid after ready() returned true or from within the continuation
+	std::optional<value_t>& value() noexcept { return m_value; }
+	std::exception_ptr&     error() noexcept { return m_error; }
+
+private:
+	template<class Assign>
+	void complete(Assign&& assign) {
+		stx::task continuation;
+		{ std::scoped_lock lock{m_mutex};
+			if(m_ready) {
+				throw std::future_error(std::future_errc::promise_already_satisfied);
+			}
+			assign();
+			m_ready = true;
+			continuation = std::move(m_continuation);
+		}
+		m_ready_cv.notify_all();
+		if(continuation) continuation();
+	}
+
+	mutable std::mutex              m_mutex;
+	mutable std::condition_variable m_ready_cv;
+	bool                            m_ready = false;
+	std::optional<value_t>          m_value;
+	std::exception_ptr              m_error;
+	stx::task                       m_continuation;
+};
+
+template<class T, class Invoke>
+void fulfill(promise<T>& p, Invoke&& invoke) noexcept;
+
+} // namespace detail
+
+// =============================================================
+// == promise<T> =============================================
+// =============================================================
+
+template<class T>
+class promise {
+public:
+	using state_t = detail::future_state<T>;
+	using value_t = detail::future_storage_t<T>;
+
+	promise() : m_state(stx::make_shared<state_t>()) {}
+	~promise() noexcept { _break(); }
+
+	promise(promise&& other) noexcept :
+		m_state(std::move(other.m_state)),
+		m_satisfied(std::exchange(other.m_satisfied, true))
+	{}
+	promise& operator=(promise&& other) noexcept {
+		_break();
+		m_state     = std::move(other.m_state);
+		m_satisfied = std::exchange(other.m_satisfied, true);
+		return *this;
+	}
+
+	promise(promise const&) = delete;
+	promise& operator=(promise const&) = delete;
+
+	future<T> get_future() const noexcept { return future<T>(m_state); }
+
+	template<class... Args>
+	void set_value(Args&&... args) {
+		m_satisfied = true;
+		m_state->set_value(value_t(std::forward<Args>(args)...));
+	}
+	void set_error(std::exception_ptr e) {
+		m_satisfied = true;
+		m_state->set_error(std::move(e));
+	}
+
+private:
+	/// Fails the future with std::future_errc::broken_promise if no value was ever set
+	void _break() noexcept {
+		if(m_state && !m_satisfied) {
+			m_satisfied = true;
+			m_state->set_error(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+		}
+	}
+
+	stx::shared<state_t> m_state;
+	bool                 m_satisfied = false;
+};
+
+// =============================================================
+// == future<T> =============================================
+// =============================================================
+
+template<class T>
+class future {
+public:
+	using value_type = T;
+	using state_t    = detail::future_state<T>;
+
+	future() noexcept {}
+	explicit future(stx::shared<state_t> state) noexcept : m_state(std::move(state)) {}
+
+	future(future&&) noexcept = default;
+	future& operator=(future&&) noexcept = default;
+	future(future const&) = delete;
+	future& operator=(future const&) = delete;
+
+	bool valid() const noexcept { return bool(m_state); }
+	bool ready() const noexcept { return m_state->ready(); }
+	void wait()  const noexcept { m_state->wait(); }
+
+	/// Blocks until the value is available and returns it, or rethrows the error. Consumes the future.
+	T get() {
+		auto state = std::move(m_state);
+		state->wait();
+		if(state->error()) std::rethrow_exception(state->error());
+		if constexpr(std::is_void_v<T>)
+			return;
+		else
+			return std::move(*state->value());
+	}
+
+	/// Calls fn with the value once it's available. Consumes the future.
+	/// Returns a future of fn's result (futures returned by fn are unwrapped). Errors skip fn and propagate.
+	template<class Fn> auto then(Fn&& fn) { return _then(nullptr, std::forward<Fn>(fn)); }
+	/// Like then(fn), but fn is deferred to the executor
+	template<class Fn> auto then(executor& e, Fn&& fn) { return _then(&e, std::forward<Fn>(fn)); }
+
+	/// Calls fn(std::exception_ptr) if the future fails. Fn returns a replacement value. Consumes the future.
+	/// Values pass through untouched.
+	template<class Fn> future<T> fail(Fn&& fn) { return _fail(nullptr, std::forward<Fn>(fn)); }
+	/// Like fail(fn), but fn is deferred to the executor
+	template<class Fn> future<T> fail(executor& e, Fn&& fn) { return _fail(&e, std::forward<Fn>(fn)); }
+
+	// Internal
+	stx::shared<state_t> const& _state() const noexcept { return m_state; }
+
+private:
+	template<class Fn>
+	auto _then(executor* e, Fn&& fn);
+	template<class Fn>
+	future<T> _fail(executor* e, Fn&& fn);
+
+	stx::shared<state_t> m_state;
+};
+
+// =============================================================
+// == Utilities =============================================
+// =============================================================
+
+/// Returns a future which already holds the value
+template<class T, class... Args>
+future<T> make_ready_future(Args&&... args) {
+	promise<T> p;
+	p.set_value(std::forward<Args>(args)...);
+	return p.get_future();
+}
+inline
+future<void> make_ready_future() { return make_ready_future<void>(); }
+
+/// Returns a future which already failed with the error
+template<class T>
+future<T> make_failed_future(std::exception_ptr e) {
+	promise<T> p;
+	p.set_error(std::move(e));
+	return p.get_future();
+}
+
+/// Executes fn on the executor and returns a future of the result
+template<class Fn>
+auto defer(executor& e, Fn&& fn) {
+	return make_ready_future().then(e, std::forward<Fn>(fn));
+}
+
+/// Completes once all futures completed, or fails with the first error
+template<class T>
+auto when_all(std::vector<future<T>> futures);
+/// Completes with a tuple of all values once all futures completed, or fails with the first error
+template<class... Ts>
+auto when_all(future<Ts>... futures);
+
+/// Completes with the index (and the value) of the first future to complete, or fails if that one failed
+template<class T>
+auto when_any(std::vector<future<T>> futures);
+
+} // namespace stx
+
+
+
+// =============================================================
+// == Inline Implementation =============================================
+// =============================================================
+
+namespace stx {
+
+namespace detail {
+
+template<class T, class Invoke>
+void fulfill(promise<T>& p, Invoke&& invoke) noexcept {
+	using R = std::invoke_result_t<Invoke>;
+	try {
+		if constexpr(is_future<R>::value) {
+			auto inner = invoke()._state();
+			inner->on_ready([inner, p = std::move(p)]() mutable {
+				if(inner->error())
+					p.set_error(inner->error());
+				else
+					p.set_value(std::move(*inner->value()));
+			});
+		}
+		else if constexpr(std::is_void_v<R>) {
+			invoke();
+			p.set_value();
+		}
+		else {
+			p.set_value(invoke());
+		}
+	}
+	catch(...) {
+		p.set_error(std::current_exception());
+	}
+}
+
+template<size_t... I, class Fn, class... Futures>
+void when_all_each(std::index_sequence<I...>, Fn&& fn, Futures&... futures) {
+	(fn(std::integral_constant<size_t, I>(), futures), ...);
+}
+
+} // namespace detail
+
+template<class T>
+template<class Fn>
+auto future<T>::_then(executor* e, Fn&& fn) {
+	using R = detail::continuation_result_t<T, std::decay_t<Fn>&>;
+	using U = typename detail::unwrap_future<R>::type;
+
+	promise<U> p;
+	future<U>  result = p.get_future();
+
+	auto state = std::move(m_state);
+	state->on_ready([e, state, fn = std::forward<Fn>(fn), p = std::move(p)]() mutable {
+		auto run = [state = std::move(state), fn = std::move(fn), p = std::move(p)]() mutable {
+			if(state->error()) {
+				p.set_error(state->error());
+				return;
+			}
+			detail::fulfill(p, [&]() -> R {
+				if constexpr(std::is_void_v<T>)
+					return fn();
+				else
+					return fn(std::move(*state->value()));
+			});
+		};
+
+		if(e)
+			e->defer(std::move(run));
+		else
+			run();
+	});
+
+	return result;
+}
+
+template<class T>
+template<class Fn>
+future<T> future<T>::_fail(executor* e, Fn&& fn) {
+	promise<T> p;
+	future<T>  result = p.get_future();
+
+	auto state = std::move(m_state);
+	state->on_ready([e, state, fn = std::forward<Fn>(fn), p = std::move(p)]() mutable {
+		if(!state->error()) {
+			p.set_value(std::move(*state->value()));
+			return;
+		}
+
+		auto run = [state = std::move(state), fn = std::move(fn), p = std::move(p)]() mutable {
+			detail::fulfill(p, [&]() { return fn(state->error()); });
+		};
+
+		if(e)
+			e->defer(std::move(run));
+		else
+			run();
+	});
+
+	return result;
+}
+
+template<class T>
+auto when_all(std::vector<future<T>> futures) {
+	using result_t = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+	struct shared_data {
+		std::mutex                                              mutex;
+		size_t                                                  remaining;
+		bool                                                    failed = false;
+		std::vector<std::optional<detail::future_storage_t<T>>> values;
+		promise<result_t>                                       p;
+	};
+
+	auto data = stx::make_shared<shared_data>();
+	data->remaining = futures.size();
+	data->values.resize(futures.size());
+	future<result_t> result = data->p.get_future();
+
+	if(futures.empty()) {
+		data->p.set_value();
+		return result;
+	}
+
+	for(size_t i = 0; i < futures.size(); i++) {
+		auto state = futures[i]._state();
+		state->on_ready([data, state, i]() {
+			std::unique_lock lock{data->mutex};
+			if(data->failed) return;
+
+			if(state->error()) {
+				data->failed = true;
+				lock.unlock();
+				data->p.set_error(state->error());
+				return;
+			}
+
+			data->values[i] = std::move(state->value());
+			if(--data->remaining > 0) return;
+			lock.unlock();
+
+			if constexpr(std::is_void_v<T>) {
+				data->p.set_value();
+			}
+			else {
+				std::vector<T> values;
+				values.reserve(data->values.size());
+				for(auto& v : data->values) values.push_back(std::move(*v));
+				data->p.set_value(std::move(values));
+			}
+		});
+	}
+
+	return result;
+}
+
+template<class... Ts>
+auto when_all(future<Ts>... futures) {
+	using result_t = std::tuple<detail::future_storage_t<Ts>...>;
+
+	struct shared_data {
+		std::mutex                                                 mutex;
+		size_t                                                     remaining = sizeof...(Ts);
+		bool                                                       failed = false;
+		std::tuple<std::optional<detail::future_storage_t<Ts>>...> values;
+		promise<result_t>                                          p;
+	};
+
+	auto data = stx::make_shared<shared_data>();
+	future<result_t> result = data->p.get_future();
+
+	detail::when_all_each(std::index_sequence_for<Ts...>(), [&data](auto index, auto& future) {
+		auto state = future._state();
+		state->on_ready([data, state]() {
+			std::unique_lock lock{data->mutex};
+			if(data->failed) return;
+
+			if(state->error()) {
+				data->failed = true;
+				lock.unlock();
+				data->p.set_error(state->error());
+				return;
+			}
+
+			std::get<decltype(index)::value>(data->values) = std::move(state->value());
+			if(--data->remaining > 0) return;
+			lock.unlock();
+
+			data->p.set_value(std::apply([](auto&... v) { return result_t(std::move(*v)...); }, data->values));
+		});
+	}, futures...);
+
+	return result;
+}
+
+template<class T>
+auto when_any(std::vector<future<T>> futures) {
+	using result_t = std::conditional_t<std::is_void_v<T>, size_t, std::pair<size_t, detail::future_storage_t<T>>>;
+
+	struct shared_data {
+		std::atomic<bool> done = false;
+		promise<result_t> p;
+	};
+
+	auto data = stx::make_shared<shared_data>();
+	future<result_t> result = data->p.get_future();
+
+	for(size_t i = 0; i < futures.size(); i++) {
+		auto state = futures[i]._state();
+		state->on_ready([data, state, i]() {
+			if(data->done.exchange(true)) return;
+
+			if(state->error())
+				data->p.set_error(state->error());
+			else if constexpr(std::is_void_v<T>)
+				data->p.set_value(i);
+			else
+				data->p.set_value(i, std::move(*state->value()));
+		});
+	}
+
+	return result;
+}
+
+} // namespace stx
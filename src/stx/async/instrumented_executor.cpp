@@ -0,0 +1,116 @@
+#include "instrumented_executor.hpp"
+
+using namespace std::chrono;
+
+namespace stx {
+
+// =============================================================
+// == latency_histogram =============================================
+// =============================================================
+
+uint64_t latency_histogram::count() const noexcept {
+	uint64_t result = 0;
+	for(uint64_t n : buckets) result += n;
+	return result;
+}
+
+nanoseconds latency_histogram::percentile(double p) const noexcept {
+	uint64_t total = count();
+	if(total == 0) return nanoseconds(0);
+
+	uint64_t rank = uint64_t(p * double(total - 1)) + 1;
+	uint64_t seen = 0;
+	for(int i = 0; i < num_buckets; i++) {
+		seen += buckets[i];
+		if(seen >= rank) return nanoseconds(uint64_t(2) << i);
+	}
+	return nanoseconds(uint64_t(2) << (num_buckets - 1));
+}
+
+// =============================================================
+// == instrumented_executor =============================================
+// =============================================================
+
+static
+void _update_max(std::atomic<uint64_t>& max, uint64_t value) noexcept {
+	uint64_t current = max.load(std::memory_order_relaxed);
+	while(value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+void instrumented_executor::atomic_histogram::record(steady_clock::duration d) noexcept {
+	auto ns = duration_cast<nanoseconds>(d).count();
+
+	int bucket = 0;
+	for(uint64_t n = ns > 0 ? uint64_t(ns) : 0; n > 1 && bucket < latency_histogram::num_buckets - 1; n >>= 1) {
+		bucket++;
+	}
+	buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+static
+uint64_t _difference(uint64_t a, uint64_t b) noexcept {
+	return a > b ? a - b : 0; // Other threads may have counted in between our loads
+}
+
+void instrumented_executor::defer(stx::task task, float priority) noexcept {
+#if STX_ASYNC_STATS
+	auto deferred_at = steady_clock::now();
+	on_deferred();
+	m_target.defer(
+		[this, deferred_at, task = std::move(task)]() mutable {
+			auto started_at = steady_clock::now();
+			task_started(started_at - deferred_at);
+			task();
+			task_finished(steady_clock::now() - started_at);
+		},
+		priority
+	);
+#else
+	m_target.defer(std::move(task), priority);
+#endif
+}
+
+void instrumented_executor::on_deferred() noexcept {
+	uint64_t deferred = m_deferred.fetch_add(1, std::memory_order_release) + 1;
+	_update_max(m_max_queue_depth, _difference(deferred, m_started.load(std::memory_order_relaxed)));
+}
+void instrumented_executor::task_started(steady_clock::duration waited) noexcept {
+	uint64_t started = m_started.fetch_add(1, std::memory_order_release) + 1;
+	_update_max(m_max_running, _difference(started, m_finished.load(std::memory_order_relaxed)));
+	m_wait_time.record(waited);
+}
+void instrumented_executor::task_finished(steady_clock::duration ran) noexcept {
+	m_finished.fetch_add(1, std::memory_order_release);
+	m_run_time.record(ran);
+}
+
+executor_stats instrumented_executor::stats() const noexcept {
+	executor_stats result;
+
+	// Read finished before started before deferred, so the differences can't underflow
+	result.finished        = m_finished.load(std::memory_order_acquire);
+	result.started         = m_started.load(std::memory_order_acquire);
+	result.deferred        = m_deferred.load(std::memory_order_acquire);
+	result.queue_depth     = result.deferred - result.started;
+	result.running         = result.started - result.finished;
+	result.max_queue_depth = m_max_queue_depth.load(std::memory_order_relaxed);
+	result.max_running     = m_max_running.load(std::memory_order_relaxed);
+
+	for(int i = 0; i < latency_histogram::num_buckets; i++) {
+		result.wait_time.buckets[i] = m_wait_time.buckets[i].load(std::memory_order_relaxed);
+		result.run_time.buckets[i]  = m_run_time.buckets[i].load(std::memory_order_relaxed);
+	}
+
+	return result;
+}
+
+void instrumented_executor::reset_stats() noexcept {
+	m_max_queue_depth.store(0, std::memory_order_relaxed);
+	m_max_running.store(0, std::memory_order_relaxed);
+	for(int i = 0; i < latency_histogram::num_buckets; i++) {
+		m_wait_time.buckets[i].store(0, std::memory_order_relaxed);
+		m_run_time.buckets[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+} // namespace stx
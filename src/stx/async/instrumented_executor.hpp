@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../async.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Set to 0 to compile instrumented_executor::defer() down to plain forwarding.
+// Has to be the same in all translation units, including the library itself, which is where defer() is compiled.
+#ifndef STX_ASYNC_STATS
+	#define STX_ASYNC_STATS 1
+#endif
+
+namespace stx {
+
+// =============================================================
+// == Snapshots =============================================
+// =============================================================
+
+/// Durations in log2 buckets: Bucket i counts durations in [2^i, 2^(i+1)) nanoseconds (Bucket 0 also counts 0ns)
+struct latency_histogram {
+	static constexpr int num_buckets = 40; //<! Up to ~18 minutes
+
+	uint64_t buckets[num_buckets] = {};
+
+	uint64_t                 count() const noexcept;
+	std::chrono::nanoseconds percentile(double p) const noexcept; //<! Upper bound of the bucket containing the p-th percentile, p in [0, 1]
+};
+
+struct executor_stats {
+	uint64_t deferred        = 0;
+	uint64_t started         = 0;
+	uint64_t finished        = 0;
+	uint64_t queue_depth     = 0; //<! Deferred, but not started yet
+	uint64_t max_queue_depth = 0;
+	uint64_t running         = 0; //<! Started, but not finished yet
+	uint64_t max_running     = 0;
+
+	latency_histogram wait_time; //<! defer() until the task started
+	latency_histogram run_time;  //<! Task started until it finished
+};
+
+// =============================================================
+// == instrumented_executor =============================================
+// =============================================================
+
+/// Wraps another executor and records counters and latency histograms of all tasks deferred through it.
+/// Recording only uses relaxed atomics, stats() can be called at any time from any thread.
+/// Every task is wrapped with its enqueue timestamp, which doesn't fit stx::task's inline storage:
+/// Instrumented tasks cost one extra allocation.
+/// The tasks record into the instrumented_executor when they run, so it has to outlive all tasks deferred through it
+/// (e.g. stop the target first, or destroy the instrumented_executor after it).
+class instrumented_executor : public executor {
+public:
+	instrumented_executor(executor& target) noexcept : m_target(target) {}
+
+	using executor::defer;
+	void defer(stx::task task, float priority = 0) noexcept override;
+	size_t num_threads() noexcept override { return m_target.num_threads(); }
+
+	executor_stats stats() const noexcept;
+	void           reset_stats() noexcept; //<! Clears histograms and high-water marks, counters keep counting (Diff snapshots for rates)
+
+	executor& target() const noexcept { return m_target; }
+
+private:
+	struct atomic_histogram {
+		std::atomic<uint64_t> buckets[latency_histogram::num_buckets] = {};
+
+		void record(std::chrono::steady_clock::duration d) noexcept;
+	};
+
+	void on_deferred() noexcept;
+	void task_started(std::chrono::steady_clock::duration waited) noexcept;
+	void task_finished(std::chrono::steady_clock::duration ran) noexcept;
+
+	executor& m_target;
+
+	alignas(64)
+	std::atomic<uint64_t> m_deferred{0};
+	std::atomic<uint64_t> m_max_queue_depth{0};
+	alignas(64)
+	std::atomic<uint64_t> m_started{0};
+	std::atomic<uint64_t> m_finished{0};
+	std::atomic<uint64_t> m_max_running{0};
+
+	atomic_histogram      m_wait_time;
+	atomic_histogram      m_run_time;
+};
+
+} // namespace stx
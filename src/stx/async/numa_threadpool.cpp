@@ -0,0 +1,45 @@
+#include "numa_threadpool.hpp"
+
+namespace stx {
+
+numa_threadpool::numa_threadpool(int threads_per_node, std::string name) noexcept :
+	m_nodes(numa_nodes())
+{
+	for(size_t i = 0; i < m_nodes.size(); i++) {
+		for(int cpu : m_nodes[i]) {
+			if(size_t(cpu) >= m_node_of_cpu.size()) m_node_of_cpu.resize(size_t(cpu) + 1, 0);
+			m_node_of_cpu[size_t(cpu)] = i;
+		}
+	}
+
+	for(size_t i = 0; i < m_nodes.size(); i++) {
+		thread_options options;
+		options.name = name + std::to_string(i);
+		options.cpus = m_nodes[i];
+
+		int count = threads_per_node > 0 ? threads_per_node : int(m_nodes[i].size());
+		m_pools.emplace_back(std::make_unique<threadpool>(count, options));
+	}
+}
+numa_threadpool::~numa_threadpool() noexcept {
+	for(auto& pool : m_pools) {
+		pool->stop();
+	}
+}
+
+size_t numa_threadpool::current_node() const noexcept {
+	int cpu = current_cpu();
+	if(cpu < 0 || size_t(cpu) >= m_node_of_cpu.size()) return 0;
+	return m_node_of_cpu[size_t(cpu)];
+}
+
+void numa_threadpool::defer(stx::task task, float priority) noexcept {
+	m_pools[current_node()]->defer(std::move(task), priority);
+}
+size_t numa_threadpool::num_threads() noexcept {
+	size_t result = 0;
+	for(auto& pool : m_pools) result += pool->num_threads();
+	return result;
+}
+
+} // namespace stx
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "threadpool.hpp"
+#include "affinity.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stx {
+
+/// One threadpool per NUMA node, with its workers pinned to the CPUs of that node.
+/// defer() queues tasks on the node of the calling CPU, so tasks deferred by a worker stay on its node
+/// and memory first touched by them stays node-local. Use node(i) to place tasks explicitly.
+class numa_threadpool : public executor {
+public:
+	/// Starts threads_per_node workers on every node (<= 0: one per CPU of the node), named "<name><node>-<index>"
+	numa_threadpool(int threads_per_node = 0, std::string name = "numa") noexcept;
+	~numa_threadpool() noexcept;
+
+	using executor::defer;
+	void defer(stx::task task, float priority = 0) noexcept override;
+	size_t num_threads() noexcept override; //<! Of all nodes
+
+	size_t         num_nodes()    const noexcept { return m_pools.size(); }
+	threadpool&    node(size_t i)       noexcept { return *m_pools[i]; }
+	cpu_set const& cpus(size_t i) const noexcept { return m_nodes[i]; }
+	size_t         current_node() const noexcept; //<! The node the calling thread runs on (0 if unknown)
+
+private:
+	std::vector<cpu_set>                     m_nodes;
+	std::vector<size_t>                      m_node_of_cpu;
+	std::vector<std::unique_ptr<threadpool>> m_pools;
+};
+
+} // namespace stx
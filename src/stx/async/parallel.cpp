@@ -0,0 +1,121 @@
+#include "parallel.hpp"
+
+#include "../shared.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+
+namespace stx {
+namespace detail {
+
+// Automatic grain size: Aim for this many chunks per participant, so uneven work still balances out
+constexpr size_t auto_chunks_per_participant = 8;
+
+namespace {
+
+struct parallel_state {
+	std::atomic<size_t>     next;      //<! First element which wasn't claimed yet
+	std::atomic<size_t>     remaining; //<! Number of elements which weren't processed yet
+	size_t                  end;
+	size_t                  grain;
+	size_t                  participants;
+
+	parallel_chunk_fn       fn;
+	void*                   context;
+
+	std::mutex              mutex;
+	std::condition_variable finished;
+	std::exception_ptr      error;
+
+	bool claim(size_t& chunk_begin, size_t& chunk_end) noexcept {
+		size_t begin = next.load(std::memory_order_relaxed);
+		while(begin < end) {
+			// Guided scheduling: Take a share of what's left, but never less than grain
+			size_t chunk = std::max(grain, (end - begin) / (2 * participants));
+			size_t until = std::min(end, begin + chunk);
+			if(next.compare_exchange_weak(begin, until, std::memory_order_relaxed)) {
+				chunk_begin = begin;
+				chunk_end   = until;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void complete(size_t count) noexcept {
+		if(remaining.fetch_sub(count, std::memory_order_acq_rel) == count) {
+			std::scoped_lock lock{mutex};
+			finished.notify_all();
+		}
+	}
+
+	/// Processes chunks until there are none left.
+	/// fn and context are only touched after a successful claim, so helpers starting late never see a dangling context.
+	void run() noexcept {
+		size_t chunk_begin, chunk_end;
+		while(claim(chunk_begin, chunk_end)) {
+			try {
+				fn(context, chunk_begin, chunk_end);
+			}
+			catch(...) {
+				{ std::scoped_lock lock{mutex};
+					if(!error) error = std::current_exception();
+				}
+				// Cancel everything that wasn't claimed yet
+				size_t unclaimed = next.exchange(end, std::memory_order_relaxed);
+				if(unclaimed < end) complete(end - unclaimed);
+			}
+			complete(chunk_end - chunk_begin);
+		}
+	}
+};
+
+} // namespace
+
+void parallel_chunks(executor& e, size_t begin, size_t end, size_t grain, parallel_chunk_fn fn, void* context) {
+	if(begin >= end) return;
+
+	// The executor's threads and the calling thread
+	size_t max_participants = e.num_threads() + 1;
+
+	size_t count = end - begin;
+	if(grain == 0) {
+		grain = std::max<size_t>(1, count / (max_participants * auto_chunks_per_participant));
+	}
+	size_t participants = std::min(max_participants, (count + grain - 1) / grain);
+
+	// Not worth splitting up
+	if(participants <= 1) {
+		fn(context, begin, end);
+		return;
+	}
+
+	auto state = stx::make_shared<parallel_state>();
+	state->next         = begin;
+	state->remaining    = count;
+	state->end          = end;
+	state->grain        = grain;
+	state->participants = participants;
+	state->fn           = fn;
+	state->context      = context;
+
+	for(size_t i = 1; i < participants; i++) {
+		e.defer([state]() { state->run(); });
+	}
+
+	// Help out instead of just waiting
+	state->run();
+
+	{ std::unique_lock lock{state->mutex};
+		state->finished.wait(lock, [&]() { return state->remaining.load(std::memory_order_acquire) == 0; });
+	}
+
+	if(state->error) {
+		std::rethrow_exception(state->error);
+	}
+}
+
+} // namespace detail
+} // namespace stx
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "../async.hpp"
+#include "../bitmap.hpp"
+#include "../bitmap3d.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace stx {
+
+// =============================================================
+// == Parallel algorithms =============================================
+// =============================================================
+// All algorithms split [begin, end) into chunks of at least grain elements (grain = 0 picks one automatically)
+// and block until every element was processed. Chunks shrink as the range runs dry (guided scheduling),
+// so early chunks are large and contiguous and the tail is still balanced.
+// The calling thread processes chunks itself, so they can be nested and used from within the executor's tasks.
+// The first exception thrown by fn cancels the remaining chunks and is rethrown to the caller.
+
+/// Calls fn(i) for every i in [begin, end), or fn(chunk_begin, chunk_end) for every chunk
+template<class Fn>
+void parallel_for(executor& e, size_t begin, size_t end, size_t grain, Fn&& fn);
+
+/// Folds every chunk with fold(T accumulator, size_t i) starting from identity, then merges the chunk results with combine(T, T).
+/// combine has to be associative and commutative, the order in which chunks are merged is unspecified.
+template<class T, class Fold, class Combine>
+T parallel_reduce(executor& e, size_t begin, size_t end, size_t grain, T identity, Fold&& fold, Combine&& combine);
+
+/// out[i] = fn(first[i]) for random access iterators
+template<class InputIt, class OutputIt, class Fn>
+OutputIt parallel_transform(executor& e, InputIt first, InputIt last, OutputIt out, size_t grain, Fn&& fn);
+
+/// Like bitmap::each() and bitmap3d::each(), but distributes scanlines across the executor
+template<class T, class Callback>
+void parallel_each(executor& e, bitmap<T> const& image, Callback&& callback, size_t grain_scanlines = 0);
+template<class T, class Callback>
+void parallel_each(executor& e, bitmap3d<T> const& image, Callback&& callback, size_t grain_scanlines = 0);
+
+namespace detail {
+
+using parallel_chunk_fn = void (*)(void* context, size_t begin, size_t end);
+
+/// Runs fn(context, chunk_begin, chunk_end) for all chunks on the calling thread and helper tasks deferred to e
+void parallel_chunks(executor& e, size_t begin, size_t end, size_t grain, parallel_chunk_fn fn, void* context);
+
+} // namespace detail
+
+} // namespace stx
+
+
+
+// =============================================================
+// == Inline Implementation =============================================
+// =============================================================
+
+namespace stx {
+
+template<class Fn>
+void parallel_for(executor& e, size_t begin, size_t end, size_t grain, Fn&& fn) {
+	auto chunk = [&fn](size_t chunk_begin, size_t chunk_end) {
+		if constexpr(std::is_invocable_v<Fn&, size_t, size_t>) {
+			fn(chunk_begin, chunk_end);
+		}
+		else {
+			for(size_t i = chunk_begin; i < chunk_end; i++) fn(i);
+		}
+	};
+	using chunk_t = decltype(chunk);
+
+	detail::parallel_chunks(e, begin, end, grain,
+		[](void* context, size_t chunk_begin, size_t chunk_end) {
+			(*static_cast<chunk_t*>(context))(chunk_begin, chunk_end);
+		},
+		&chunk
+	);
+}
+
+template<class T, class Fold, class Combine>
+T parallel_reduce(executor& e, size_t begin, size_t end, size_t grain, T identity, Fold&& fold, Combine&& combine) {
+	std::mutex mutex;
+	T          result = identity;
+
+	parallel_for(e, begin, end, grain, [&](size_t chunk_begin, size_t chunk_end) {
+		T accumulator = identity;
+		for(size_t i = chunk_begin; i < chunk_end; i++) {
+			accumulator = fold(std::move(accumulator), i);
+		}
+
+		std::scoped_lock lock{mutex};
+		result = combine(std::move(result), std::move(accumulator));
+	});
+
+	return result;
+}
+
+template<class InputIt, class OutputIt, class Fn>
+OutputIt parallel_transform(executor& e, InputIt first, InputIt last, OutputIt out, size_t grain, Fn&& fn) {
+	size_t count = size_t(std::distance(first, last));
+	parallel_for(e, 0, count, grain, [&](size_t chunk_begin, size_t chunk_end) {
+		InputIt  in  = first + chunk_begin;
+		OutputIt dst = out + chunk_begin;
+		for(size_t i = chunk_begin; i < chunk_end; i++) {
+			*dst++ = fn(*in++);
+		}
+	});
+	return out + count;
+}
+
+template<class T, class Callback>
+void parallel_each(executor& e, bitmap<T> const& image, Callback&& callback, size_t grain_scanlines) {
+	using u32 = typename bitmap<T>::u32;
+
+	parallel_for(e, 0, image.h, grain_scanlines, [&](size_t chunk_begin, size_t chunk_end) {
+		for(u32 y = u32(chunk_begin); y < chunk_end; y++) {
+			T* scanline = image.data + size_t(y) * image.elements_per_scanline;
+			for(u32 x = 0; x < image.w; x++) {
+				if constexpr(std::is_invocable_v<Callback, T&, u32, u32>)
+					callback(scanline[x], x, y);
+				else
+					callback(scanline[x]);
+			}
+		}
+	});
+}
+
+template<class T, class Callback>
+void parallel_each(executor& e, bitmap3d<T> const& image, Callback&& callback, size_t grain_scanlines) {
+	using u32 = typename bitmap3d<T>::u32;
+
+	// Scanlines of all slices form one iteration space, so thin volumes are still split up
+	parallel_for(e, 0, size_t(image.h) * image.d, grain_scanlines, [&](size_t chunk_begin, size_t chunk_end) {
+		for(size_t row = chunk_begin; row < chunk_end; row++) {
+			u32 y = u32(row % image.h);
+			u32 z = u32(row / image.h);
+			T* scanline = image.data + size_t(z) * image.elements_per_slice + size_t(y) * image.elements_per_scanline;
+			for(u32 x = 0; x < image.w; x++) {
+				if constexpr(std::is_invocable_v<Callback, T&, u32, u32, u32>)
+					callback(scanline[x], x, y, z);
+				else
+					callback(scanline[x]);
+			}
+		}
+	});
+}
+
+} // namespace stx
@@ -0,0 +1,184 @@
+#include "priority_task_queue.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if __has_include(<bit>)
+	#include <bit>
+#endif
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+namespace stx {
+
+static
+int _lowest_bit(uint32_t mask) noexcept {
+#if defined(__cpp_lib_bitops)
+	return std::countr_zero(mask);
+#elif defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(mask);
+#else
+	int result = 0;
+	while(!(mask & 1)) { mask >>= 1; result++; }
+	return result;
+#endif
+}
+
+priority_task_queue::priority_task_queue(scheduling_mode mode) noexcept :
+	m_mode(mode),
+	m_nonempty_levels(0),
+	m_finish(false),
+	m_num_threads(0),
+	m_num_sleeping(0)
+{
+	// 100us for level 0, doubling with every level (~25ms for priority 0)
+	for(int i = 0; i < num_levels; i++) {
+		m_deadlines[i] = 100us * (1 << i);
+	}
+}
+priority_task_queue::~priority_task_queue() noexcept {
+	stop();
+}
+
+/// Not std::isnan() or a comparison: With fast math (See premake5.lua) the compiler assumes there are no NaNs and drops those
+static
+bool _is_nan(float f) noexcept {
+	uint32_t bits;
+	std::memcpy(&bits, &f, sizeof(bits));
+	return (bits & 0x7FFFFFFF) > 0x7F800000;
+}
+
+int priority_task_queue::level_of(float priority) noexcept {
+	if(_is_nan(priority)) return 0;
+	if(priority < -num_levels / 2) return 0;
+	if(priority >= num_levels / 2) return num_levels - 1;
+
+	return int(std::floor(priority)) + num_levels / 2;
+}
+
+void priority_task_queue::set_deadline(int level, clock::duration relative_deadline) noexcept {
+	if(level < 0 || level >= num_levels) return;
+
+	std::scoped_lock lock{m_mutex};
+	m_deadlines[level] = relative_deadline;
+}
+
+size_t priority_task_queue::size() noexcept {
+	std::scoped_lock lock{m_mutex};
+	size_t result = 0;
+	for(auto& level : m_levels) result += level.size();
+	return result;
+}
+
+void priority_task_queue::defer(stx::task task, float priority) noexcept {
+	defer_level(std::move(task), level_of(priority));
+}
+void priority_task_queue::defer_level(stx::task task, int level) noexcept {
+	level = std::clamp(level, 0, num_levels - 1);
+
+	// Only deadline mode pays for reading the clock
+	clock::time_point now = m_mode == deadline ? clock::now() : clock::time_point{};
+
+	std::scoped_lock lock{m_mutex};
+	m_levels[level].push_back({std::move(task), now + m_deadlines[level]});
+	m_nonempty_levels |= uint32_t(1) << level;
+
+	// Only pay for the wakeup if somebody is actually sleeping
+	if(m_num_sleeping > 0) {
+		m_sleeping_threads.notify_one();
+	}
+}
+
+int priority_task_queue::next_level() const noexcept {
+	int best = _lowest_bit(m_nonempty_levels);
+	if(m_mode == strict) return best;
+
+	// Deadlines within a level are monotonic, so only the front of every level has to be compared
+	uint32_t rest = m_nonempty_levels & (m_nonempty_levels - 1);
+	while(rest) {
+		int level = _lowest_bit(rest);
+		if(m_levels[level].front().deadline < m_levels[best].front().deadline) {
+			best = level;
+		}
+		rest &= rest - 1;
+	}
+	return best;
+}
+
+bool priority_task_queue::try_pop(stx::task& task) noexcept {
+	if(!m_nonempty_levels) return false;
+
+	auto& queue = m_levels[next_level()];
+	task = std::move(queue.front().task);
+	queue.pop_front();
+	if(queue.empty()) {
+		m_nonempty_levels &= ~(uint32_t(1) << (&queue - m_levels));
+	}
+	return true;
+}
+
+bool priority_task_queue::execute_tasks() noexcept {
+	return execute_tasks(clock::time_point::max());
+}
+bool priority_task_queue::execute_tasks(clock::time_point until) noexcept {
+	stx::task task;
+	bool result = false;
+
+	// Pop one task at a time: Urgent tasks deferred by a running task jump ahead of the remaining bulk work
+	do {
+		{ std::scoped_lock lock{m_mutex};
+			if(!try_pop(task)) break;
+		}
+		result = true;
+
+		task();
+		task = nullptr;
+	} while(until == clock::time_point::max() || clock::now() < until);
+
+	return result;
+}
+
+void priority_task_queue::start() noexcept {
+	stx::task task;
+
+	std::unique_lock lock{m_mutex};
+	m_finish = false;
+	++m_num_threads;
+
+	while(true) {
+		// Sleep until we have a task, defer() and stop() wake us up
+		while(!m_nonempty_levels && !m_finish) {
+			++m_num_sleeping;
+			m_sleeping_threads.wait(lock);
+			--m_num_sleeping;
+		}
+		if(m_finish) break;
+
+		try_pop(task);
+
+		lock.unlock();
+		task();
+		task = nullptr;
+		lock.lock();
+	}
+
+	if(--m_num_threads == 0) {
+		m_stopped_threads.notify_all();
+	}
+}
+void priority_task_queue::stop() noexcept {
+	{ std::unique_lock lock{m_mutex};
+		m_finish = true;
+		m_sleeping_threads.notify_all(); // Wake up all threads, so they can return
+		m_stopped_threads.wait(lock, [this]() { return m_num_threads == 0; });
+	}
+	execute_tasks(); // Execute all pending tasks
+}
+size_t priority_task_queue::num_threads() noexcept {
+	std::scoped_lock lock{m_mutex};
+	return size_t(m_num_threads);
+}
+
+} // namespace stx
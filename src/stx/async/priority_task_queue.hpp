@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../async.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace stx {
+
+/// A task queue with a small, fixed number of priority levels, each backed by its own FIFO queue.
+/// defer() and picking the next task are O(1): A bitmask tracks which levels have pending tasks.
+/// Float priorities map onto levels via level_of(), lower priorities run first (Like task_queue).
+///
+/// In strict mode a task never waits behind a task of a lower level.
+/// In deadline mode every level has a relative deadline and the task with the earliest deadline runs first (EDF),
+/// so bulk work still makes progress under a steady stream of urgent tasks.
+class priority_task_queue : public executor {
+public:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr int num_levels = 16;
+
+	enum scheduling_mode {
+		strict,  //<! Always run the lowest non-empty level first
+		deadline //<! Earliest deadline first, using the relative deadline of each level
+	};
+
+	priority_task_queue(scheduling_mode mode = strict) noexcept;
+	~priority_task_queue() noexcept;
+
+	using executor::defer;
+	void defer(stx::task task, float priority = 0) noexcept override;
+	/// level is clamped to [0, num_levels), like level_of() does
+	void defer_level(stx::task task, int level) noexcept;
+
+	bool execute_tasks() noexcept;                         //<! Runs tasks until the queue is empty
+	bool execute_tasks(clock::time_point until) noexcept;  //<! Runs tasks until the queue is empty or the time is up, e.g. once per frame
+	void start() noexcept; //<! Executes tasks on the calling thread until stop() is called, also after a previous stop()
+	void stop()  noexcept; //<! Makes all start() calls return, then executes the remaining tasks
+
+	size_t num_threads() noexcept override; //<! Threads currently in start()
+
+	/// Sets the relative deadline of a level (Only used in deadline mode). Levels outside [0, num_levels) are ignored.
+	void set_deadline(int level, clock::duration relative_deadline) noexcept;
+
+	scheduling_mode mode() const noexcept { return m_mode; }
+	size_t          size() noexcept;
+
+	/// Maps a float priority onto a level: floor(priority) + num_levels / 2, clamped to [0, num_levels)
+	static int level_of(float priority) noexcept;
+
+private:
+	struct entry {
+		stx::task         task;
+		clock::time_point deadline;
+	};
+
+	bool try_pop(stx::task& task) noexcept; //<! Requires m_mutex
+	int  next_level() const noexcept;       //<! Requires m_mutex and m_nonempty_levels != 0
+
+	scheduling_mode   m_mode;
+	clock::duration   m_deadlines[num_levels];
+
+	// All guarded by m_mutex
+	std::deque<entry> m_levels[num_levels];
+	uint32_t          m_nonempty_levels;
+	bool              m_finish;
+	int               m_num_threads;
+	int               m_num_sleeping;
+
+	std::mutex              m_mutex;
+	std::condition_variable m_sleeping_threads;
+	std::condition_variable m_stopped_threads;
+};
+
+} // namespace stx
@@ -0,0 +1,98 @@
+#include "socket_reactor.hpp"
+
+#ifdef STX_LINUX_SOCKETS
+
+extern "C" {
+	#include <poll.h>
+	#include <unistd.h>
+}
+
+namespace stx {
+
+socket_reactor::socket_reactor() noexcept :
+	m_finish(false)
+{
+	if(::pipe(m_wake_pipe) != 0) {
+		std::terminate();
+	}
+	// Non-blocking, so wake() never stalls on a full pipe
+	::fcntl(m_wake_pipe[0], F_SETFL, O_NONBLOCK);
+	::fcntl(m_wake_pipe[1], F_SETFL, O_NONBLOCK);
+	m_thread = std::thread([this]() { run(); });
+}
+socket_reactor::~socket_reactor() noexcept {
+	{ std::scoped_lock lock{m_mutex};
+		m_finish = true;
+	}
+	wake();
+	m_thread.join();
+	::close(m_wake_pipe[0]);
+	::close(m_wake_pipe[1]);
+}
+
+void socket_reactor::watch(int handle, readiness r, stx::task on_ready, executor& e) noexcept {
+	{ std::scoped_lock lock{m_mutex};
+		m_pending.push_back({
+			handle,
+			short(r == readable ? POLLIN : POLLOUT),
+			std::move(on_ready),
+			&e
+		});
+	}
+	wake();
+}
+
+void socket_reactor::wake() noexcept {
+	char c = 0;
+	(void) !::write(m_wake_pipe[1], &c, 1);
+}
+
+void socket_reactor::run() noexcept {
+	std::vector<watcher> watchers;
+	std::vector<pollfd>  fds;
+
+	while(true) {
+		{ std::scoped_lock lock{m_mutex};
+			if(m_finish) break;
+			for(auto& w : m_pending) {
+				watchers.push_back(std::move(w));
+			}
+			m_pending.clear();
+		}
+
+		fds.clear();
+		fds.push_back({m_wake_pipe[0], POLLIN, 0});
+		for(auto& w : watchers) {
+			fds.push_back({w.handle, w.events, 0});
+		}
+
+		if(::poll(fds.data(), fds.size(), -1) < 0) continue;
+
+		if(fds[0].revents) {
+			char buffer[64];
+			while(::read(m_wake_pipe[0], buffer, sizeof(buffer)) > 0);
+		}
+
+		// Defer tasks of ready sockets and remove their watchers
+		size_t kept = 0;
+		for(size_t i = 0; i < watchers.size(); i++) {
+			if(fds[i + 1].revents) {
+				watchers[i].e->defer(std::move(watchers[i].on_ready));
+			}
+			else {
+				if(kept != i) watchers[kept] = std::move(watchers[i]);
+				kept++;
+			}
+		}
+		watchers.erase(watchers.begin() + kept, watchers.end());
+	}
+}
+
+socket_reactor& global_socket_reactor() noexcept {
+	static socket_reactor reactor;
+	return reactor;
+}
+
+} // namespace stx
+
+#endif // STX_LINUX_SOCKETS
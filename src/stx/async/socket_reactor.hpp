@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../async.hpp"
+#include "../socket.hpp"
+
+#ifdef STX_LINUX_SOCKETS
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stx {
+
+/// Waits for sockets to become readable or writable on a background thread (using poll())
+/// and defers a task to an executor once they are.
+class socket_reactor {
+public:
+	enum readiness {
+		readable,
+		writable
+	};
+
+	socket_reactor() noexcept;
+	~socket_reactor() noexcept; //<! Tasks that are still waiting are dropped
+
+	/// Defers on_ready to e once the socket is ready (or closed/errored). One-shot.
+	void watch(int handle, readiness r, stx::task on_ready, executor& e) noexcept;
+
+private:
+	struct watcher {
+		int       handle;
+		short     events;
+		stx::task on_ready;
+		executor* e;
+	};
+
+	void run() noexcept;
+	void wake() noexcept;
+
+	std::mutex           m_mutex;
+	std::vector<watcher> m_pending;
+	bool                 m_finish;
+	int                  m_wake_pipe[2];
+	std::thread          m_thread;
+};
+
+socket_reactor& global_socket_reactor() noexcept;
+
+} // namespace stx
+
+#endif // STX_LINUX_SOCKETS
@@ -1,35 +1,108 @@
 #pragma once
 
-#include "../async.hpp"
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
 
-// TODO
+#ifndef STX_TASK_INLINE_SIZE
+	#define STX_TASK_INLINE_SIZE 64 //<! Bytes of captured state stx::task can store without allocating
+#endif
 
 namespace stx {
 
-template<class Callback>
-class task_builder {
-	stx::executor& m_executor;
-	Callback       m_callback;
+// =============================================================
+// == basic_task =============================================
+// =============================================================
 
-	template<class Callback2>
-	auto then(Callback2&& cb) {
-		return task_builder {
-			m_executor,
-			[callback = std::move(cb)]() {
+/// A move-only void() callable like std::function<void()>, but with a configurable inline buffer.
+/// Callables up to InlineSize bytes (which are nothrow move constructible) are stored without allocating.
+template<size_t InlineSize>
+class basic_task {
+public:
+	template<class F>
+	static constexpr bool stored_inline =
+		sizeof(F) <= InlineSize &&
+		alignof(F) <= alignof(std::max_align_t) &&
+		std::is_nothrow_move_constructible_v<F>;
 
+	basic_task() noexcept : m_vtable(nullptr) {}
+	basic_task(std::nullptr_t) noexcept : m_vtable(nullptr) {}
+	~basic_task() noexcept { reset(); }
+
+	template<class F, class = std::enable_if_t<
+		!std::is_same_v<std::decay_t<F>, basic_task> &&
+		std::is_invocable_v<std::decay_t<F>&>>>
+	basic_task(F&& f) {
+		using Fn = std::decay_t<F>;
+		if constexpr(std::is_pointer_v<Fn> || std::is_same_v<Fn, std::function<void()>>) {
+			if(!f) { m_vtable = nullptr; return; }
+		}
+		if constexpr(stored_inline<Fn>) {
+			new(m_storage) Fn(std::forward<F>(f));
+			m_vtable = &inline_vtable<Fn>;
+		}
+		else {
+			*reinterpret_cast<Fn**>(m_storage) = new Fn(std::forward<F>(f));
+			m_vtable = &heap_vtable<Fn>;
+		}
+	}
+
+	basic_task(basic_task&& other) noexcept : m_vtable(nullptr) { *this = std::move(other); }
+	basic_task& operator=(basic_task&& other) noexcept {
+		if(this != &other) {
+			reset();
+			if(other.m_vtable) {
+				other.m_vtable->move(other.m_storage, m_storage);
+				m_vtable = std::exchange(other.m_vtable, nullptr);
 			}
-		};
+		}
+		return *this;
 	}
+	basic_task& operator=(std::nullptr_t) noexcept { reset(); return *this; }
 
-	template<class Callback2>
-	auto fail(Callback2&& cb) {
+	basic_task(basic_task const&) = delete;
+	basic_task& operator=(basic_task const&) = delete;
 
+	void reset() noexcept {
+		if(m_vtable) {
+			std::exchange(m_vtable, nullptr)->destroy(m_storage);
+		}
 	}
-};
 
-template<class Callback>
-auto defer(Callback&& cb) {
+	void operator()() { m_vtable->invoke(m_storage); }
+
+	explicit operator bool() const noexcept { return m_vtable != nullptr; }
+
+private:
+	struct vtable {
+		void (*invoke)(void* self);
+		void (*move)(void* from, void* to) noexcept;
+		void (*destroy)(void* self) noexcept;
+	};
+
+	template<class Fn>
+	static constexpr vtable inline_vtable = {
+		[](void* self) { (*static_cast<Fn*>(self))(); },
+		[](void* from, void* to) noexcept {
+			new(to) Fn(std::move(*static_cast<Fn*>(from)));
+			static_cast<Fn*>(from)->~Fn();
+		},
+		[](void* self) noexcept { static_cast<Fn*>(self)->~Fn(); }
+	};
+
+	template<class Fn>
+	static constexpr vtable heap_vtable = {
+		[](void* self) { (**static_cast<Fn**>(self))(); },
+		[](void* from, void* to) noexcept { *static_cast<Fn**>(to) = *static_cast<Fn**>(from); },
+		[](void* self) noexcept { delete *static_cast<Fn**>(self); }
+	};
+
+	alignas(std::max_align_t) unsigned char m_storage[InlineSize < sizeof(void*) ? sizeof(void*) : InlineSize];
+	vtable const* m_vtable;
+};
 
-}
+using task = basic_task<STX_TASK_INLINE_SIZE>;
 
-} // namespace stx
\ No newline at end of file
+} // namespace stx
@@ -0,0 +1,90 @@
+#include "task_group.hpp"
+
+namespace stx {
+
+// =============================================================
+// == cancellation_source =============================================
+// =============================================================
+
+cancellation_source::cancellation_source() noexcept :
+	m_state(stx::make_shared<detail::cancellation_state>())
+{}
+cancellation_source::cancellation_source(cancellation_token const& parent) noexcept :
+	m_state(stx::make_shared<detail::cancellation_state>())
+{
+	m_state->parent = parent._state();
+}
+
+// =============================================================
+// == task_group =============================================
+// =============================================================
+
+task_group::task_group(executor& e) noexcept :
+	m_executor(e),
+	m_state(stx::make_shared<state>())
+{}
+task_group::task_group(executor& e, cancellation_token const& parent) noexcept :
+	task_group(e)
+{
+	m_state->cancellation = cancellation_source(parent);
+}
+task_group::~task_group() noexcept {
+	try {
+		wait();
+	}
+	catch(...) {}
+}
+
+void task_group::add(stx::task task, float priority) noexcept {
+	{ std::scoped_lock lock{m_state->mutex};
+		m_state->pending.push_back(std::move(task));
+		m_state->unfinished++;
+	}
+
+	// The task might already have been run by wait() by the time this executes
+	m_executor.defer([s = m_state]() { s->run_one(); }, priority);
+}
+
+bool task_group::state::run_one() noexcept {
+	stx::task task;
+	{ std::scoped_lock lock{mutex};
+		if(pending.empty()) return false;
+		task = std::move(pending.front());
+		pending.pop_front();
+	}
+
+	if(!cancellation.cancelled()) {
+		try {
+			task();
+		}
+		catch(task_cancelled const&) {
+			// Expected once the group was cancelled, not an error
+		}
+		catch(...) {
+			std::scoped_lock lock{mutex};
+			if(!error) error = std::current_exception();
+			cancellation.cancel(); // Fail fast: Skip everything that didn't start yet
+		}
+	}
+	task = nullptr;
+
+	std::scoped_lock lock{mutex};
+	if(--unfinished == 0) {
+		finished.notify_all();
+	}
+	return true;
+}
+
+void task_group::wait() {
+	// Help out instead of just waiting
+	while(m_state->run_one());
+
+	std::unique_lock lock{m_state->mutex};
+	m_state->finished.wait(lock, [this]() { return m_state->unfinished == 0; });
+
+	if(m_state->error) {
+		std::rethrow_exception(std::exchange(m_state->error, nullptr));
+	}
+}
+
+} // namespace stx
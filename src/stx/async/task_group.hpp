@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../async.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+
+namespace stx {
+
+// =============================================================
+// == Cancellation =============================================
+// =============================================================
+
+/// Thrown by cancellation_token::throw_if_cancelled()
+struct task_cancelled : public std::exception {
+	const char* what() const noexcept override { return "Task was cancelled"; }
+};
+
+namespace detail {
+
+struct cancellation_state {
+	std::atomic<bool>               cancelled{false};
+	stx::shared<cancellation_state> parent; //<! Cancelling the parent cancels this too
+
+	bool is_cancelled() const noexcept {
+		return cancelled.load(std::memory_order_relaxed) || (parent && parent->is_cancelled());
+	}
+};
+
+} // namespace detail
+
+/// The reading end of a cancellation_source. Tasks poll it to stop early (Cooperative cancellation).
+/// A default constructed token is never cancelled.
+class cancellation_token {
+public:
+	cancellation_token() noexcept {}
+
+	bool cancelled() const noexcept { return m_state && m_state->is_cancelled(); }
+	void throw_if_cancelled() const { if(cancelled()) throw task_cancelled(); }
+
+	/// Makes tokens usable as guard in executor::defer(callback, guard, priority)
+	bool lock() const noexcept { return !cancelled(); }
+
+	// Internal
+	cancellation_token(stx::shared<detail::cancellation_state> state) noexcept : m_state(std::move(state)) {}
+	stx::shared<detail::cancellation_state> const& _state() const noexcept { return m_state; }
+
+private:
+	stx::shared<detail::cancellation_state> m_state;
+};
+
+/// Cancels all of its tokens at once, e.g. when a request was abandoned
+class cancellation_source {
+public:
+	cancellation_source() noexcept;
+	/// Also cancelled once parent is
+	explicit cancellation_source(cancellation_token const& parent) noexcept;
+
+	void               cancel()    noexcept { m_state->cancelled = true; }
+	bool               cancelled() const noexcept { return m_state->is_cancelled(); }
+	cancellation_token token()     const noexcept { return cancellation_token(m_state); }
+
+private:
+	stx::shared<detail::cancellation_state> m_state;
+};
+
+// =============================================================
+// == task_group =============================================
+// =============================================================
+
+/// A set of tasks which can be waited for and cancelled together.
+/// Tasks can take a cancellation_token to stop early. Tasks that didn't start yet are skipped once the group is cancelled.
+/// The first exception thrown by a task cancels the group and is rethrown by wait().
+/// wait() executes tasks which didn't start yet on the calling thread, so groups can be waited for from within the executor.
+class task_group {
+public:
+	task_group(executor& e = global_threadpool()) noexcept;
+	task_group(executor& e, cancellation_token const& parent) noexcept; //<! Cancelled along with parent
+	~task_group() noexcept; //<! Waits for all tasks, exceptions which weren't rethrown by wait() are dropped
+
+	task_group(task_group const&) = delete;
+	task_group& operator=(task_group const&) = delete;
+
+	/// Runs fn() or fn(cancellation_token) on the executor
+	template<class Fn>
+	void run(Fn&& fn, float priority = 0) noexcept;
+
+	/// Blocks until all tasks finished, then rethrows the first exception thrown by a task
+	void wait();
+
+	void               cancel()    noexcept { m_state->cancellation.cancel(); }
+	bool               cancelled() const noexcept { return m_state->cancellation.cancelled(); }
+	cancellation_token token()     const noexcept { return m_state->cancellation.token(); }
+
+private:
+	struct state {
+		std::mutex              mutex;
+		std::condition_variable finished;
+		std::deque<stx::task>   pending;
+		size_t                  unfinished = 0;
+		std::exception_ptr      error;
+		cancellation_source     cancellation;
+
+		bool run_one() noexcept; //<! Runs the oldest pending task, returns false if there was none
+	};
+
+	void add(stx::task task, float priority) noexcept;
+
+	executor&          m_executor;
+	stx::shared<state> m_state;
+};
+
+} // namespace stx
+
+
+
+// =============================================================
+// == Inline Implementation =============================================
+// =============================================================
+
+namespace stx {
+
+template<class Fn>
+void task_group::run(Fn&& fn, float priority) noexcept {
+	if constexpr(std::is_invocable_v<std::decay_t<Fn>&, cancellation_token>) {
+		add([fn = std::forward<Fn>(fn), token = token()]() mutable { fn(token); }, priority);
+	}
+	else {
+		add(std::forward<Fn>(fn), priority);
+	}
+}
+
+} // namespace stx
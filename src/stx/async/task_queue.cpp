@@ -1,24 +1,40 @@
 #include "task_queue.hpp"
 
-#include <chrono>
-#include <cstdio>
-
-using namespace std::chrono;
-using namespace std::chrono_literals;
-
 namespace stx {
 
 // =============================================================
 // == task_queue =============================================
 // =============================================================
-void task_queue::defer(std::function<void()> task, float priority) noexcept {
+void task_queue::defer(stx::task task, float priority) noexcept {
 	std::scoped_lock lock{m_mutex};
 
 	m_tasks.emplace(priority, std::move(task));
 }
 
+timer_handle task_queue::defer_at(clock::time_point due, stx::task task, float priority) noexcept {
+	std::scoped_lock lock{m_mutex};
+	return m_timers.add(due, clock::duration::zero(), std::move(task), priority);
+}
+timer_handle task_queue::defer_after(clock::duration delay, stx::task task, float priority) noexcept {
+	return defer_at(clock::now() + delay, std::move(task), priority);
+}
+timer_handle task_queue::defer_every(clock::duration period, stx::task task, float priority) noexcept {
+	std::scoped_lock lock{m_mutex};
+	return m_timers.add(clock::now() + period, period, std::move(task), priority);
+}
+std::optional<task_queue::clock::time_point> task_queue::next_timer() noexcept {
+	std::scoped_lock lock{m_mutex};
+	return m_timers.next_due();
+}
+
 bool task_queue::execute_tasks() noexcept {
-	std::multimap<float, std::function<void()>> tasks;
+	{ std::scoped_lock lock{m_mutex};
+		if(!m_timers.empty()) {
+			m_timers.pop_due(clock::now(), m_tasks);
+		}
+	}
+
+	std::multimap<float, stx::task> tasks;
 	bool result = false;
 	while(true) {
 		// Get tasks
@@ -31,7 +47,7 @@ bool task_queue::execute_tasks() noexcept {
 		// Execute tasks
 		for(auto& [prio, task] : tasks) {
 			// Move task out of queue and execute
-			std::function<void()>(std::move(task))();
+			stx::task(std::move(task))();
 		}
 
 		// Clear executed tasks
@@ -46,73 +62,151 @@ bool task_queue::execute_tasks() noexcept {
 
 task_queue_mt::task_queue_mt() noexcept :
 	m_finish(false),
-	m_num_threads(0)
+	m_num_threads(0),
+	m_num_sleeping(0),
+	m_timer_wait(clock::time_point::max())
 {}
 task_queue_mt::~task_queue_mt() noexcept {
 	stop();
 }
 
-void task_queue_mt::defer(std::function<void()> fn, float prio) noexcept {
-	{ std::scoped_lock lock{m_mutex};
-		m_tasks.emplace(prio, std::move(fn));
+void task_queue_mt::defer(stx::task fn, float prio) noexcept {
+	std::scoped_lock lock{m_mutex};
+	m_tasks.emplace(prio, std::move(fn));
+
+	// Only pay for the wakeup if somebody is actually sleeping
+	if(m_num_sleeping > 0) {
+		m_sleeping_threads.notify_one();
+	}
+}
+timer_handle task_queue_mt::defer_at(clock::time_point due, stx::task task, float priority) noexcept {
+	return add_timer(due, clock::duration::zero(), std::move(task), priority);
+}
+timer_handle task_queue_mt::defer_after(clock::duration delay, stx::task task, float priority) noexcept {
+	return add_timer(clock::now() + delay, clock::duration::zero(), std::move(task), priority);
+}
+timer_handle task_queue_mt::defer_every(clock::duration period, stx::task task, float priority) noexcept {
+	return add_timer(clock::now() + period, period, std::move(task), priority);
+}
+timer_handle task_queue_mt::add_timer(clock::time_point due, clock::duration period, stx::task task, float priority) noexcept {
+	std::scoped_lock lock{m_mutex};
+	timer_handle result = m_timers.add(due, period, std::move(task), priority);
+
+	// Somebody has to wait for this timer
+	if(due < m_timer_wait && m_num_sleeping > 0) {
+		if(m_timer_wait == clock::time_point::max())
+			m_sleeping_threads.notify_one(); // Nobody waits for timers yet: Any worker will do
+		else
+			m_sleeping_threads.notify_all(); // The timer worker has to wait for an earlier time, we can't wake it up selectively
+	}
+
+	return result;
+}
+void task_queue_mt::pop_due_timers() noexcept {
+	if(m_timers.empty()) return;
+
+	size_t added = m_timers.pop_due(clock::now(), m_tasks);
+
+	// We take one of them ourselves
+	for(size_t i = 1; i < added && int(i) <= m_num_sleeping; i++) {
+		m_sleeping_threads.notify_one();
 	}
-	m_sleeping_threads.notify_one();
 }
+
 void task_queue_mt::execute_tasks() noexcept {
-	++m_num_threads;
+	stx::task task;
 
-	std::function<void()> task;
+	{ std::scoped_lock lock{m_mutex};
+		pop_due_timers();
+	}
 
 	while(true) {
-		std::unique_lock lock{m_mutex};
+		{ std::scoped_lock lock{m_mutex};
 
-		// See if we have a task
-		if(m_tasks.empty()) break;
+			// See if we have a task
+			if(m_tasks.empty()) break;
 
-		// Get the task
-		task = std::move(m_tasks.begin()->second);
-		m_tasks.erase(m_tasks.begin());
+			// Get the task
+			task = std::move(m_tasks.begin()->second);
+			m_tasks.erase(m_tasks.begin());
+		}
 
 		// Execute the task
 		task();
 	}
-
-	--m_num_threads;
 }
 void task_queue_mt::start() noexcept {
-	m_finish = false;
+	restart();
+	work();
+}
+void task_queue_mt::work() noexcept {
+	stx::task task;
 
+	std::unique_lock lock{m_mutex};
 	++m_num_threads;
 
-	std::function<void()> task;
-
-	while(!m_finish) {
-		{ std::unique_lock lock{m_mutex};
-
-			// Wait until we have a task
-			while(m_tasks.empty()) {
-				if(m_finish) goto DONE;
-				m_sleeping_threads.wait_for(lock, 10ms, [this]() { return m_finish || !m_tasks.empty(); });
+	while(true) {
+		// Sleep until we have a task: defer() and stop() wake us up, timers are waited for by one worker at a time
+		while(!m_finish) {
+			pop_due_timers();
+			if(!m_tasks.empty()) break;
+
+			auto next_timer = m_timer_wait == clock::time_point::max() ? m_timers.next_due() : std::nullopt;
+
+			++m_num_sleeping;
+			if(next_timer) {
+				m_timer_wait = *next_timer;
+				m_sleeping_threads.wait_until(lock, m_timer_wait);
+				m_timer_wait = clock::time_point::max();
+
+				// Hand waiting for timers over to the next sleeping worker, in case we got a task instead
+				if(!m_tasks.empty() && m_num_sleeping > 1) {
+					m_sleeping_threads.notify_one();
+				}
+			}
+			else {
+				m_sleeping_threads.wait(lock);
 			}
+			--m_num_sleeping;
+		}
+		if(m_finish) break;
 
-			// Get the task
-			task = std::move(m_tasks.begin()->second);
-			m_tasks.erase(m_tasks.begin());
+		// Get the task
+		task = std::move(m_tasks.begin()->second);
+		m_tasks.erase(m_tasks.begin());
+
+		// Nobody waits for the remaining timers while we run the task (e.g. we just popped a due one): Wake a sleeping worker to do that
+		if(m_timer_wait == clock::time_point::max() && !m_timers.empty() && m_num_sleeping > 0) {
+			m_sleeping_threads.notify_one();
 		}
 
 		// Execute the task
+		lock.unlock();
 		task();
+		task = nullptr;
+		lock.lock();
 	}
 
-DONE:
-	--m_num_threads;
+	if(--m_num_threads == 0) {
+		m_stopped_threads.notify_all();
+	}
 }
 void task_queue_mt::stop() noexcept {
-	m_finish = true;
-
-	m_sleeping_threads.notify_all(); // Wake up all threads, so they can be joined
+	{ std::unique_lock lock{m_mutex};
+		m_finish = true;
+		m_sleeping_threads.notify_all(); // Wake up all threads, so they can return
+		m_stopped_threads.wait(lock, [this]() { return m_num_threads == 0; });
+		m_timers.clear();
+	}
 	execute_tasks(); // Execute all pending tasks
-	while(m_num_threads > 0); // Spin until all threads are finished
+}
+size_t task_queue_mt::num_threads() noexcept {
+	std::scoped_lock lock{m_mutex};
+	return size_t(m_num_threads);
+}
+void task_queue_mt::restart() noexcept {
+	std::scoped_lock lock{m_mutex};
+	m_finish = false;
 }
 
 } // namespace stx
@@ -1,9 +1,8 @@
 #pragma once
 
 #include "../async.hpp"
+#include "timer_queue.hpp"
 
-#include <functional>
-#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <map>
@@ -12,34 +11,68 @@ namespace stx {
 
 class task_queue : public executor {
 public:
+	using clock = timer_queue::clock;
+
 	task_queue() noexcept {}
 	~task_queue() noexcept {}
-	void defer(std::function<void()> task, float priority = 0) noexcept override;
-	bool execute_tasks() noexcept;
+	using executor::defer;
+	void defer(stx::task task, float priority = 0) noexcept override;
+	bool execute_tasks() noexcept; //<! Also runs all timers which are due
+
+	timer_handle defer_at(clock::time_point due, stx::task task, float priority = 0) noexcept;
+	timer_handle defer_after(clock::duration delay, stx::task task, float priority = 0) noexcept;
+	timer_handle defer_every(clock::duration period, stx::task task, float priority = 0) noexcept; //<! First run after one period
+
+	std::optional<clock::time_point> next_timer() noexcept; //<! When execute_tasks() has to be called next for timers
 
 private:
-	std::mutex                                  m_mutex;
-	std::multimap<float, std::function<void()>> m_tasks;
+	std::mutex                      m_mutex;
+	std::multimap<float, stx::task> m_tasks;
+	timer_queue                     m_timers;
 };
 
 class task_queue_mt : public executor {
 public:
+	using clock = timer_queue::clock;
+
 	task_queue_mt() noexcept;
 	~task_queue_mt() noexcept;
 
-	void defer(std::function<void()> task, float priority = 0) noexcept;
+	using executor::defer;
+	void defer(stx::task task, float priority = 0) noexcept override;
 	void execute_tasks() noexcept;
-	void start() noexcept;
-	void stop()  noexcept;
+	void start() noexcept; //<! Executes tasks on the calling thread until stop() is called, also after a previous stop()
+	void stop()  noexcept; //<! Makes all start() calls return, then executes the remaining tasks (Timers which aren't due yet are dropped)
+
+	size_t num_threads() noexcept override; //<! Threads currently in start()
+
+	/// Timers: One sleeping worker waits until the next timer is due, the others sleep without timeout
+	timer_handle defer_at(clock::time_point due, stx::task task, float priority = 0) noexcept;
+	timer_handle defer_after(clock::duration delay, stx::task task, float priority = 0) noexcept;
+	timer_handle defer_every(clock::duration period, stx::task task, float priority = 0) noexcept; //<! First run after one period
+
+protected:
+	/// For worker threads: Like start(), but returns at once after stop() until restart() is called.
+	/// A worker thread which only gets here after its pool was stopped would otherwise never return.
+	void work()    noexcept;
+	void restart() noexcept;
 
 private:
-	volatile bool                               m_finish;
-	std::atomic<int>                            m_num_threads;
+	timer_handle add_timer(clock::time_point due, clock::duration period, stx::task task, float priority) noexcept;
+	void         pop_due_timers() noexcept; //<! Requires m_mutex
+
+	// All guarded by m_mutex
+	bool                            m_finish;
+	int                             m_num_threads;
+	int                             m_num_sleeping;
+	clock::time_point               m_timer_wait; //<! What the worker waiting for timers waits for, max() if none is
 
-	std::multimap<float, std::function<void()>> m_tasks;
+	std::multimap<float, stx::task> m_tasks;
+	timer_queue                     m_timers;
 
-	std::mutex                                  m_mutex;
-	std::condition_variable                     m_sleeping_threads;
+	std::mutex                      m_mutex;
+	std::condition_variable         m_sleeping_threads;
+	std::condition_variable         m_stopped_threads;
 };
 
 } // namespace stx
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "task_ring.hpp"
+
+#include <thread>
+#include <cstdint>
+#include <utility>
+
+namespace stx {
+
+// How often a blocked producer retries before it goes to sleep
+constexpr unsigned blocking_spin_count = 64;
+
+/// The ring whose tasks the current thread executes (Innermost one if they are nested), see overflow_policy
+static thread_local task_ring* t_consuming = nullptr;
+
+namespace {
+
+struct consuming_scope {
+	task_ring* previous;
+
+	consuming_scope(task_ring* ring) noexcept : previous(std::exchange(t_consuming, ring)) {}
+	~consuming_scope() noexcept { t_consuming = previous; }
+};
+
+} // namespace
+
+static
+size_t _next_power_of_two(size_t n) {
+	size_t result = 2;
+	while(result < n) result <<= 1;
+	return result;
+}
+
+task_ring::task_ring(size_t capacity, overflow_policy policy) noexcept :
+	m_mask(_next_power_of_two(capacity) - 1),
+	m_policy(policy),
+	m_enqueue_pos(0),
+	m_dequeue_pos(0),
+	m_num_rejected(0),
+	m_num_sleeping_consumers(0),
+	m_num_blocked_producers(0),
+	m_num_threads(0),
+	m_finish(false)
+{
+	m_cells.reset(new cell[m_mask + 1]);
+	for(size_t i = 0; i <= m_mask; i++) {
+		m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+task_ring::~task_ring() noexcept {
+	stop();
+}
+
+bool task_ring::try_defer(stx::task&& task) noexcept {
+	cell*  c;
+	size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+	while(true) {
+		c = &m_cells[pos & m_mask];
+		size_t   seq = c->sequence.load(std::memory_order_acquire);
+		intptr_t dif = intptr_t(seq) - intptr_t(pos);
+		if(dif == 0) {
+			if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if(dif < 0) {
+			return false; // Full
+		}
+		else {
+			pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	c->task = std::move(task);
+	c->sequence.store(pos + 1, std::memory_order_release);
+
+	// Pairs with the increment in start(): Either we see the sleeping consumer, or it sees our task
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(m_num_sleeping_consumers.load(std::memory_order_relaxed) > 0) {
+		{ std::scoped_lock lock{m_mutex}; }
+		m_sleeping_consumers.notify_one();
+	}
+	return true;
+}
+
+void task_ring::defer(stx::task task, float priority) noexcept {
+	(void) priority;
+
+	if(try_defer(std::move(task))) return;
+
+	// A consumer waiting for room might wait for itself: Make room instead
+	if(t_consuming == this && m_policy != reject) {
+		stx::task other;
+		while(!try_defer(std::move(task))) {
+			if(try_pop(other)) {
+				other();
+				other = nullptr;
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		return;
+	}
+
+	switch(m_policy) {
+		case reject: {
+			++m_num_rejected;
+		} return;
+		case spin: {
+			while(!try_defer(std::move(task)));
+		} return;
+		case block: {
+			for(unsigned i = 0; i < blocking_spin_count; i++) {
+				if(try_defer(std::move(task))) return;
+				std::this_thread::yield();
+			}
+
+			do {
+				std::unique_lock lock{m_mutex};
+				++m_num_blocked_producers;
+				m_blocked_producers.wait(lock, [this]() { return !maybe_full(); });
+				--m_num_blocked_producers;
+			} while(!try_defer(std::move(task)));
+		} return;
+	}
+}
+
+bool task_ring::try_pop(stx::task& task) noexcept {
+	cell*  c;
+	size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+	while(true) {
+		c = &m_cells[pos & m_mask];
+		size_t   seq = c->sequence.load(std::memory_order_acquire);
+		intptr_t dif = intptr_t(seq) - intptr_t(pos + 1);
+		if(dif == 0) {
+			if(m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if(dif < 0) {
+			return false; // Empty
+		}
+		else {
+			pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	task = std::move(c->task);
+	c->task = nullptr;
+	c->sequence.store(pos + m_mask + 1, std::memory_order_release);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(m_num_blocked_producers.load(std::memory_order_relaxed) > 0) {
+		{ std::scoped_lock lock{m_mutex}; }
+		m_blocked_producers.notify_all();
+	}
+	return true;
+}
+
+bool task_ring::maybe_empty() const noexcept {
+	return m_enqueue_pos.load() == m_dequeue_pos.load();
+}
+bool task_ring::maybe_full() const noexcept {
+	return m_enqueue_pos.load() - m_dequeue_pos.load() > m_mask;
+}
+
+bool task_ring::execute_tasks() noexcept {
+	consuming_scope scope(this);
+
+	stx::task task;
+	bool result = false;
+	while(try_pop(task)) {
+		task();
+		result = true;
+	}
+	return result;
+}
+
+void task_ring::start() noexcept {
+	consuming_scope scope(this);
+	++m_num_threads;
+
+	stx::task task;
+	while(true) {
+		if(try_pop(task)) {
+			task();
+			continue;
+		}
+
+		std::unique_lock lock{m_mutex};
+		if(m_finish) break;
+		++m_num_sleeping_consumers;
+		m_sleeping_consumers.wait(lock, [this]() { return m_finish || !maybe_empty(); });
+		--m_num_sleeping_consumers;
+	}
+
+	{ std::scoped_lock lock{m_mutex};
+		--m_num_threads;
+	}
+	m_stopped_threads.notify_all();
+}
+
+void task_ring::stop() noexcept {
+	{ std::unique_lock lock{m_mutex};
+		m_finish = true;
+		m_sleeping_consumers.notify_all(); // Wake up all threads, so they can return
+		m_stopped_threads.wait(lock, [this]() { return m_num_threads == 0; });
+	}
+	execute_tasks(); // Execute all pending tasks
+	m_finish = false;
+}
+
+} // namespace stx
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../async.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+namespace stx {
+
+/// A bounded, lock-free multi-producer/multi-consumer task queue (Dmitry Vyukov's ring buffer).
+/// All slots are allocated up front: Producers never touch the allocator and only take a mutex to wake up sleeping consumers.
+/// Priorities are ignored, tasks are executed in FIFO order.
+class task_ring : public executor {
+public:
+	/// What defer() does when the ring is full.
+	/// Tasks running in start() or execute_tasks() of this ring never wait (block and spin): They execute queued tasks
+	/// themselves until there's room, so consumers deferring into a full ring (e.g. parallel_for) can't deadlock.
+	enum overflow_policy {
+		block,  //<! Wait until a consumer made room (Spins shortly before sleeping). Blocks forever if nobody consumes.
+		spin,   //<! Busy-wait until a consumer made room
+		reject  //<! Drop the task, see num_rejected()
+	};
+
+	task_ring(size_t capacity = 4096, overflow_policy policy = block) noexcept;
+	~task_ring() noexcept;
+
+	using executor::defer;
+	void defer(stx::task task, float priority = 0) noexcept override;
+	bool try_defer(stx::task&& task) noexcept; //<! Returns false and leaves task untouched if the ring is full
+
+	bool execute_tasks() noexcept;
+	void start() noexcept;
+	void stop()  noexcept;
+
+	size_t num_threads() noexcept override { return size_t(m_num_threads.load(std::memory_order_relaxed)); } //<! Threads currently in start()
+
+	size_t          capacity()     const noexcept { return m_mask + 1; }
+	overflow_policy policy()       const noexcept { return m_policy; }
+	size_t          num_rejected() const noexcept { return m_num_rejected; }
+
+private:
+	struct cell {
+		std::atomic<size_t> sequence;
+		stx::task           task;
+	};
+
+	bool try_pop(stx::task& task) noexcept;
+	bool maybe_empty() const noexcept;
+	bool maybe_full()  const noexcept;
+
+	std::unique_ptr<cell[]> m_cells;
+	size_t                  m_mask;
+	overflow_policy         m_policy;
+
+	alignas(64) std::atomic<size_t> m_enqueue_pos;
+	alignas(64) std::atomic<size_t> m_dequeue_pos;
+
+	alignas(64)
+	std::atomic<size_t>     m_num_rejected;
+	std::atomic<unsigned>   m_num_sleeping_consumers;
+	std::atomic<unsigned>   m_num_blocked_producers;
+	std::atomic<int>        m_num_threads;
+	std::atomic<bool>       m_finish;
+
+	std::mutex              m_mutex;
+	std::condition_variable m_sleeping_consumers;
+	std::condition_variable m_blocked_producers;
+	std::condition_variable m_stopped_threads;
+};
+
+} // namespace stx
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "task_queue.hpp"
+#include "affinity.hpp"
 
 #include <thread>
 #include <vector>
@@ -11,26 +12,31 @@ class threadpool : public task_queue_mt {
 	std::vector<std::thread> m_threads;
 public:
 	threadpool() noexcept {}
-	threadpool(int count) noexcept {
-		start(count);
+	threadpool(int count, thread_options const& options = {}) noexcept {
+		start(count, options);
 	}
 
 	~threadpool() noexcept { stop(); }
 
-	void start(int count = 0) noexcept {
+	/// Starts count worker threads (hardware_concurrency() - 1 if count <= 0), named and pinned according to options
+	void start(int count = 0, thread_options const& options = {}) noexcept {
 		stop();
+		restart();
 
 		if(count <= 0) {
 			count = std::thread::hardware_concurrency() - 1;
 		}
 
 		for(int i = 0; i < count; i++) {
-			m_threads.emplace_back([this]() {
-				task_queue_mt::start();
+			m_threads.emplace_back([this, options, i]() {
+				apply_thread_options(options, unsigned(i));
+				work();
 			});
 		}
 	}
 
+	size_t num_threads() noexcept override { return m_threads.size(); } //<! Including threads which didn't start running tasks yet
+
 	void stop() noexcept {
 		task_queue_mt::stop();
 		for(auto& thread : m_threads) {
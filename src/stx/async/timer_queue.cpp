@@ -0,0 +1,62 @@
+#include "timer_queue.hpp"
+
+#include <algorithm>
+
+namespace stx {
+
+timer_handle timer_queue::add(clock::time_point due, clock::duration period, stx::task fn, float priority) noexcept {
+	auto state = stx::make_shared<timer_handle::state>();
+	state->fn = std::move(fn);
+
+	m_heap.push_back({due, period, priority, state});
+	std::push_heap(m_heap.begin(), m_heap.end(), later);
+
+	return timer_handle(std::move(state));
+}
+
+size_t timer_queue::pop_due(clock::time_point now, std::multimap<float, stx::task>& tasks) noexcept {
+	size_t result = 0;
+
+	while(!m_heap.empty() && m_heap.front().due <= now) {
+		std::pop_heap(m_heap.begin(), m_heap.end(), later);
+		timer t = std::move(m_heap.back());
+		m_heap.pop_back();
+
+		if(t.state->cancelled) continue;
+
+		if(t.period <= clock::duration::zero()) {
+			tasks.emplace(t.priority, [state = std::move(t.state)]() {
+				if(!state->cancelled) state->fn();
+			});
+		}
+		else {
+			tasks.emplace(t.priority, [state = t.state]() {
+				if(state->cancelled || state->running.exchange(true)) return;
+				state->fn();
+				state->running = false;
+			});
+
+			// Fixed rate, but missed runs are skipped instead of piling up
+			t.due += t.period;
+			if(t.due <= now) t.due = now + t.period;
+
+			m_heap.push_back(std::move(t));
+			std::push_heap(m_heap.begin(), m_heap.end(), later);
+		}
+		result++;
+	}
+
+	return result;
+}
+
+std::optional<timer_queue::clock::time_point> timer_queue::next_due() noexcept {
+	while(!m_heap.empty() && m_heap.front().state->cancelled) {
+		std::pop_heap(m_heap.begin(), m_heap.end(), later);
+		m_heap.pop_back();
+	}
+
+	if(m_heap.empty()) return std::nullopt;
+	return m_heap.front().due;
+}
+
+} // namespace stx
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "task.hpp"
+#include "../shared.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace stx {
+
+// =============================================================
+// == timer_handle =============================================
+// =============================================================
+
+/// Returned by defer_at(), defer_after() and defer_every(), cancels the timer
+class timer_handle {
+public:
+	struct state {
+		std::atomic<bool> cancelled{false};
+		std::atomic<bool> running{false}; //<! Periodic tasks skip a run instead of overlapping with the previous one
+		stx::task         fn;
+	};
+
+	timer_handle() noexcept {}
+	timer_handle(stx::shared<state> s) noexcept : m_state(std::move(s)) {}
+
+	/// The task won't be started anymore (A run which already started isn't interrupted)
+	void cancel() noexcept { if(m_state) m_state->cancelled = true; }
+	bool cancelled() const noexcept { return !m_state || m_state->cancelled; }
+
+private:
+	stx::shared<state> m_state;
+};
+
+// =============================================================
+// == timer_queue =============================================
+// =============================================================
+
+/// A binary min-heap of timers, which moves due timers into a task queue.
+/// Not synchronized: Owners guard it with their own mutex (See task_queue and task_queue_mt).
+class timer_queue {
+public:
+	using clock = std::chrono::steady_clock;
+
+	/// Adds a timer running fn at due, then every period if period > 0
+	timer_handle add(clock::time_point due, clock::duration period, stx::task fn, float priority) noexcept;
+
+	/// Moves tasks of all timers due at now into tasks and re-arms periodic ones. Returns the number of tasks added.
+	size_t pop_due(clock::time_point now, std::multimap<float, stx::task>& tasks) noexcept;
+
+	std::optional<clock::time_point> next_due() noexcept; //<! Also drops cancelled timers from the top of the heap
+
+	bool   empty() const noexcept { return m_heap.empty(); } //<! Might still contain cancelled timers
+	size_t size()  const noexcept { return m_heap.size(); }
+	void   clear()       noexcept { m_heap.clear(); }
+
+private:
+	struct timer {
+		clock::time_point                due;
+		clock::duration                  period;
+		float                            priority;
+		stx::shared<timer_handle::state> state;
+	};
+
+	// Earliest timer on top of the heap
+	static bool later(timer const& a, timer const& b) noexcept { return a.due > b.due; }
+
+	std::vector<timer> m_heap;
+};
+
+} // namespace stx
@@ -0,0 +1,182 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+
+namespace stx {
+
+static thread_local work_stealing_pool* t_current_pool   = nullptr;
+static thread_local void*               t_current_worker = nullptr;
+
+// How often an idle worker looks for tasks before it parks
+constexpr unsigned idle_spin_count = 64;
+
+work_stealing_pool::work_stealing_pool() noexcept :
+	m_num_queued(0),
+	m_num_parked(0),
+	m_finish(false)
+{}
+work_stealing_pool::work_stealing_pool(int count) noexcept :
+	work_stealing_pool()
+{
+	start(count);
+}
+work_stealing_pool::~work_stealing_pool() noexcept {
+	stop();
+}
+
+void work_stealing_pool::defer(stx::task task, float priority) noexcept {
+	(void) priority;
+
+	if(t_current_pool == this) {
+		// Deferred from one of our workers: Keep it local
+		worker& self = *static_cast<worker*>(t_current_worker);
+		std::scoped_lock lock{self.mutex};
+		self.tasks.push_back(std::move(task));
+	}
+	else {
+		std::scoped_lock lock{m_injection_mutex};
+		m_injection_queue.push_back(std::move(task));
+	}
+
+	++m_num_queued;
+	wake_one();
+}
+
+void work_stealing_pool::start(int count) noexcept {
+	stop();
+
+	if(count <= 0) {
+		count = std::max(1, int(std::thread::hardware_concurrency()) - 1);
+	}
+
+	m_finish = false;
+
+	// Create all workers before starting any thread, thieves iterate m_workers
+	for(int i = 0; i < count; i++) {
+		m_workers.emplace_back(std::make_unique<worker>());
+		m_workers.back()->random_state = 2463534242u + unsigned(i) * 7919u;
+	}
+	for(auto& w : m_workers) {
+		worker* self = w.get();
+		self->thread = std::thread([this, self]() {
+			run(*self);
+		});
+	}
+}
+
+void work_stealing_pool::stop() noexcept {
+	{ std::scoped_lock lock{m_park_mutex};
+		m_finish = true;
+	}
+	m_parked_threads.notify_all(); // Wake up all threads, so they can be joined
+
+	for(auto& w : m_workers) {
+		w->thread.join();
+	}
+
+	// Execute all pending tasks
+	stx::task task;
+	bool progress;
+	do {
+		progress = false;
+		for(auto& w : m_workers) {
+			while(try_pop(*w, task)) {
+				task();
+				progress = true;
+			}
+		}
+		while(try_pop_injected(task)) {
+			task();
+			progress = true;
+		}
+	} while(progress);
+
+	m_workers.clear();
+}
+
+void work_stealing_pool::run(worker& self) noexcept {
+	t_current_pool   = this;
+	t_current_worker = &self;
+
+	stx::task task;
+	unsigned idle = 0;
+	while(true) {
+		if(try_pop(self, task) || try_pop_injected(task) || try_steal(self, task)) {
+			task();
+			task = nullptr;
+			idle = 0;
+			continue;
+		}
+
+		if(++idle < idle_spin_count) {
+			std::this_thread::yield();
+			continue;
+		}
+		idle = 0;
+
+		// Park until there is something to do
+		std::unique_lock lock{m_park_mutex};
+		if(m_finish) break;
+		++m_num_parked;
+		m_parked_threads.wait(lock, [this]() { return m_finish || m_num_queued > 0; });
+		--m_num_parked;
+	}
+
+	t_current_pool   = nullptr;
+	t_current_worker = nullptr;
+}
+
+bool work_stealing_pool::try_pop(worker& self, stx::task& task) noexcept {
+	std::scoped_lock lock{self.mutex};
+	if(self.tasks.empty()) return false;
+
+	task = std::move(self.tasks.back());
+	self.tasks.pop_back();
+	--m_num_queued;
+	return true;
+}
+
+bool work_stealing_pool::try_pop_injected(stx::task& task) noexcept {
+	std::scoped_lock lock{m_injection_mutex};
+	if(m_injection_queue.empty()) return false;
+
+	task = std::move(m_injection_queue.front());
+	m_injection_queue.pop_front();
+	--m_num_queued;
+	return true;
+}
+
+bool work_stealing_pool::try_steal(worker& self, stx::task& task) noexcept {
+	size_t n = m_workers.size();
+	if(n <= 1) return false;
+
+	// xorshift32
+	unsigned x = self.random_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	self.random_state = x;
+
+	for(size_t i = 0; i < n; i++) {
+		worker& victim = *m_workers[(x + i) % n];
+		if(&victim == &self) continue;
+
+		std::unique_lock lock{victim.mutex, std::try_to_lock};
+		if(!lock || victim.tasks.empty()) continue;
+
+		task = std::move(victim.tasks.front());
+		victim.tasks.pop_front();
+		--m_num_queued;
+		return true;
+	}
+	return false;
+}
+
+void work_stealing_pool::wake_one() noexcept {
+	if(m_num_parked > 0) {
+		{ std::scoped_lock lock{m_park_mutex}; }
+		m_parked_threads.notify_one();
+	}
+}
+
+} // namespace stx
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../async.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <memory>
+#include <vector>
+
+namespace stx {
+
+/// A thread pool which gives every worker its own task deque.
+/// Workers push to and pop from the back of their own deque and steal from the front of a random victim once they run dry.
+/// Tasks deferred from outside of the pool go through a global injection queue.
+/// Priorities are ignored: Tasks deferred from a worker run roughly LIFO on that worker, everything else roughly FIFO.
+class work_stealing_pool : public executor {
+public:
+	work_stealing_pool() noexcept;
+	work_stealing_pool(int count) noexcept;
+	~work_stealing_pool() noexcept;
+
+	using executor::defer;
+	void defer(stx::task task, float priority = 0) noexcept override;
+
+	void start(int count = 0) noexcept;
+	void stop() noexcept;
+
+	unsigned size() const noexcept { return unsigned(m_workers.size()); }
+	size_t   num_threads() noexcept override { return m_workers.size(); }
+
+private:
+	struct worker {
+		alignas(64)
+		std::mutex            mutex;
+		std::deque<stx::task> tasks;
+		std::thread           thread;
+		unsigned              random_state;
+	};
+
+	void run(worker& self) noexcept;
+	bool try_pop(worker& self, stx::task& task) noexcept;
+	bool try_pop_injected(stx::task& task) noexcept;
+	bool try_steal(worker& self, stx::task& task) noexcept;
+	void wake_one() noexcept;
+
+	std::vector<std::unique_ptr<worker>> m_workers;
+
+	std::mutex              m_injection_mutex;
+	std::deque<stx::task>   m_injection_queue;
+
+	alignas(64)
+	std::atomic<size_t>     m_num_queued;
+	std::atomic<unsigned>   m_num_parked;
+	std::atomic<bool>       m_finish;
+
+	std::mutex              m_park_mutex;
+	std::condition_variable m_parked_threads;
+};
+
+} // namespace stx
@@ -56,6 +56,14 @@ public:
 		m_prev = d;
 	}
 
+	/// Links the list starting at d after this element, without taking d out of its list.
+	/// This has to be the last element of its list and d the first of its own, e.g. for joining lists built separately.
+	void append_list(Derived* d) noexcept {
+		m_next = d;
+		if(d)
+			static_cast<element_t*>(d)->m_prev = (Derived*)this;
+	}
+
 	void remove() {
 		if(m_next)
 			m_next->m_prev = m_prev;
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "list.hpp"
+#include "object_pool.hpp"
 
 #include <utility>
 
@@ -42,8 +43,9 @@ public:
 	void removeListeners() { (ListenerTypes::remove(), ...); }
 };
 
+/// Allocated from the object pools, since events tend to have lots of small, short lived callbacks
 template<class C, bool autodelete = true, class... Args>
-class callback_listener final : public listener<Args...> {
+class callback_listener final : public listener<Args...>, public pooled_object {
 	C m_callback;
 public:
 	template<class... CArgs>
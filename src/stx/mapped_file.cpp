@@ -0,0 +1,121 @@
+#include "mapped_file.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+	#define STX_MAPPED_FILE_MMAP 1
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace stx {
+
+static
+std::runtime_error _error(const char* what, const char* path) {
+	return std::runtime_error(std::string(what) + " '" + path + "'");
+}
+
+mapped_file::mapped_file(const char* path, bool map) {
+#ifdef STX_MAPPED_FILE_MMAP
+	if(map) {
+		int fd = ::open(path, O_RDONLY);
+		if(fd < 0) throw _error("Failed opening file", path);
+
+		struct stat info;
+		if(::fstat(fd, &info) != 0) {
+			::close(fd);
+			throw _error("Failed reading size of file", path);
+		}
+		m_size = size_t(info.st_size);
+		if(m_size == 0) {
+			::close(fd);
+			return;
+		}
+
+		// The rest of the file's last page reads as zeros. If the file ends exactly on a page boundary,
+		// the terminator comes from an extra anonymous page mapped right after it.
+		size_t page_size = size_t(::sysconf(_SC_PAGESIZE));
+		size_t mapping_size = (m_size / page_size + 1) * page_size;
+
+		void* reserved = ::mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(reserved == MAP_FAILED) {
+			::close(fd);
+			throw _error("Failed mapping file", path);
+		}
+		void* file = ::mmap(reserved, m_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+		::close(fd);
+		if(file == MAP_FAILED) {
+			::munmap(reserved, mapping_size);
+			throw _error("Failed mapping file", path);
+		}
+		::madvise(file, m_size, MADV_SEQUENTIAL);
+
+		m_data         = static_cast<char*>(file);
+		m_mapping_size = mapping_size;
+		return;
+	}
+#endif
+
+	FILE* file = std::fopen(path, "rb");
+	if(!file) throw _error("Failed opening file", path);
+
+	std::fseek(file, 0, SEEK_END);
+	long size = std::ftell(file);
+	std::fseek(file, 0, SEEK_SET);
+	if(size < 0) {
+		std::fclose(file);
+		throw _error("Failed reading size of file", path);
+	}
+
+	m_size = size_t(size);
+	m_data = new char[m_size + 1];
+	size_t read = std::fread(m_data, 1, m_size, file);
+	std::fclose(file);
+	m_data[m_size] = '\0';
+
+	if(read != m_size) {
+		close();
+		throw _error("Failed reading file", path);
+	}
+}
+
+mapped_file::~mapped_file() noexcept {
+	close();
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept :
+	m_data(std::exchange(other.m_data, nullptr)),
+	m_size(std::exchange(other.m_size, 0)),
+	m_mapping_size(std::exchange(other.m_mapping_size, 0))
+{}
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+	if(this != &other) {
+		close();
+		m_data         = std::exchange(other.m_data, nullptr);
+		m_size         = std::exchange(other.m_size, 0);
+		m_mapping_size = std::exchange(other.m_mapping_size, 0);
+	}
+	return *this;
+}
+
+void mapped_file::close() noexcept {
+#ifdef STX_MAPPED_FILE_MMAP
+	if(m_mapping_size > 0) {
+		::munmap(m_data, m_mapping_size);
+	}
+	else
+#endif
+	{
+		delete[] m_data;
+	}
+	m_data         = nullptr;
+	m_size         = 0;
+	m_mapping_size = 0;
+}
+
+} // namespace stx
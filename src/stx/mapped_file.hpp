@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace stx {
+
+/// The whole content of a file, read only and always followed by a '\0' (So it can be parsed like a C string).
+/// Memory mapped where possible, so pages are only read when touched and the file isn't copied.
+/// Otherwise (or if asked to) the file is read into a buffer.
+class mapped_file {
+public:
+	mapped_file() noexcept {}
+	/// Throws std::runtime_error if the file can't be opened or read
+	explicit mapped_file(const char* path, bool map = true);
+	~mapped_file() noexcept;
+
+	mapped_file(mapped_file&& other) noexcept;
+	mapped_file& operator=(mapped_file&& other) noexcept;
+
+	const char*      c_str()  const noexcept { return m_data ? m_data : ""; }
+	size_t           size()   const noexcept { return m_size; }
+	std::string_view view()   const noexcept { return { c_str(), m_size }; }
+	bool             mapped() const noexcept { return m_mapping_size > 0; }
+
+private:
+	void close() noexcept;
+
+	char*  m_data         = nullptr;
+	size_t m_size         = 0;
+	size_t m_mapping_size = 0; //<! 0 if m_data was allocated with new[]
+};
+
+} // namespace stx
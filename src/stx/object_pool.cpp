@@ -0,0 +1,275 @@
+#include "object_pool.hpp"
+#include "allocation_tracking.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace stx {
+
+namespace {
+
+constexpr size_t slab_size   = 64 * 1024;
+constexpr size_t num_classes = object_pool_max_size / object_pool_alignment;
+
+struct free_node {
+	free_node* next;
+};
+
+struct local_pool;
+
+struct alignas(object_pool_alignment) slab {
+	std::atomic<free_node*>  remote_free{nullptr}; //<! Frees from other threads, taken as a whole by the owner
+	std::atomic<local_pool*> owner{nullptr};       //<! nullptr while orphaned
+	slab*                    next = nullptr;       //<! In the owner's list or the orphan list
+};
+
+struct size_class {
+	size_t          object_size = 0;
+	std::mutex      mutex;
+	slab*           orphans = nullptr; //<! Slabs of exited threads, guarded by mutex
+	allocation_tag* tag     = nullptr; //<! Only with STX_ALLOC_TRACKING
+};
+
+/// The pool of one size class on one thread
+struct local_pool {
+	size_class* cls      = nullptr;
+	free_node*  free     = nullptr;
+	slab*       slabs    = nullptr;
+	char*       bump     = nullptr; //<! Never used part of the newest slab
+	char*       bump_end = nullptr;
+
+	void* alloc();
+	void  free_local(void* p) noexcept;
+	void  orphan_all() noexcept; //<! Hands all slabs to the size class for adoption by other threads
+
+private:
+	void refill();
+	bool collect_remote() noexcept;
+	bool adopt_orphans() noexcept;
+	void new_slab();
+	void take(slab* s) noexcept;
+};
+
+size_class* _size_classes() noexcept {
+	// Never destroyed: Objects might be freed during static destruction
+	static size_class* classes = []() {
+		auto* result = new size_class[num_classes];
+		for(size_t i = 0; i < num_classes; i++) {
+			result[i].object_size = (i + 1) * object_pool_alignment;
+#if STX_ALLOC_TRACKING
+			result[i].tag = &allocation_tag_named("stx::object_pool<" + std::to_string(result[i].object_size) + ">");
+#endif
+		}
+		return result;
+	}();
+	return classes;
+}
+
+size_t _class_index(size_t bytes) noexcept {
+	return bytes == 0 ? 0 : (bytes - 1) / object_pool_alignment;
+}
+
+slab* _slab_of(void* p) noexcept {
+	return reinterpret_cast<slab*>(uintptr_t(p) & ~uintptr_t(slab_size - 1));
+}
+
+void _push_remote(slab* s, free_node* first, free_node* last) noexcept {
+	free_node* head = s->remote_free.load(std::memory_order_relaxed);
+	do last->next = head;
+	while(!s->remote_free.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// ** Thread local pools *******************************************************
+
+thread_local bool t_pools_destroyed = false;
+
+struct thread_pools {
+	local_pool pools[num_classes];
+
+	thread_pools() noexcept {
+		for(size_t i = 0; i < num_classes; i++) {
+			pools[i].cls = &_size_classes()[i];
+		}
+	}
+	~thread_pools() noexcept {
+		for(auto& pool : pools) pool.orphan_all();
+		t_pools_destroyed = true;
+	}
+};
+
+/// nullptr once the calling thread is exiting
+local_pool* _local_pool(size_t index) noexcept {
+	if(t_pools_destroyed) return nullptr;
+	static thread_local thread_pools pools;
+	return &pools.pools[index];
+}
+
+// ** local_pool *******************************************************
+
+void* local_pool::alloc() {
+	if(!free && size_t(bump_end - bump) < cls->object_size) {
+		refill();
+	}
+
+	if(free) {
+		free_node* result = free;
+		free = result->next;
+		return result;
+	}
+
+	char* result = bump;
+	bump += cls->object_size;
+	return result;
+}
+
+void local_pool::free_local(void* p) noexcept {
+	auto* node = static_cast<free_node*>(p);
+	node->next = free;
+	free = node;
+}
+
+void local_pool::refill() {
+	if(collect_remote()) return;
+	if(adopt_orphans()) return;
+	new_slab();
+}
+
+bool local_pool::collect_remote() noexcept {
+	for(slab* s = slabs; s; s = s->next) {
+		free_node* list = s->remote_free.exchange(nullptr, std::memory_order_acquire);
+		if(!list) continue;
+
+		free_node* last = list;
+		while(last->next) last = last->next;
+		last->next = free;
+		free = list;
+	}
+	return free != nullptr;
+}
+
+bool local_pool::adopt_orphans() noexcept {
+	std::scoped_lock lock{cls->mutex};
+	while(cls->orphans && !free) {
+		slab* s = cls->orphans;
+		cls->orphans = s->next;
+		take(s);
+
+		free = s->remote_free.exchange(nullptr, std::memory_order_acquire);
+	}
+	return free != nullptr;
+}
+
+#if STX_ALLOC_TRACKING
+allocation_tag& _slab_tag() noexcept {
+	static allocation_tag& tag = allocation_tag_named("stx::object_pool slabs");
+	return tag;
+}
+allocation_tag& _big_tag() noexcept {
+	static allocation_tag& tag = allocation_tag_named("stx::object_pool<big>");
+	return tag;
+}
+#endif
+
+void local_pool::new_slab() {
+	void* memory = ::operator new(slab_size, std::align_val_t(slab_size));
+#if STX_ALLOC_TRACKING
+	_slab_tag().on_alloc(slab_size);
+#endif
+	slab* s = new(memory) slab();
+	take(s);
+
+	bump     = reinterpret_cast<char*>(s + 1);
+	bump_end = reinterpret_cast<char*>(s) + slab_size;
+}
+
+void local_pool::take(slab* s) noexcept {
+	s->owner.store(this, std::memory_order_relaxed);
+	s->next = slabs;
+	slabs   = s;
+}
+
+void local_pool::orphan_all() noexcept {
+	if(!slabs) return;
+
+	// Everything still free goes to the slabs' remote lists, where the adopting thread finds it
+	while(free) {
+		free_node* node = free;
+		free = node->next;
+		_push_remote(_slab_of(node), node, node);
+	}
+	for(; size_t(bump_end - bump) >= cls->object_size; bump += cls->object_size) {
+		auto* node = reinterpret_cast<free_node*>(bump);
+		_push_remote(_slab_of(node), node, node);
+	}
+
+	slab* last = slabs;
+	for(slab* s = slabs; s; s = s->next) {
+		s->owner.store(nullptr, std::memory_order_release);
+		last = s;
+	}
+
+	std::scoped_lock lock{cls->mutex};
+	last->next   = cls->orphans;
+	cls->orphans = slabs;
+	slabs        = nullptr;
+}
+
+} // namespace
+
+// =============================================================
+// == Public interface =============================================
+// =============================================================
+
+void* pool_alloc(size_t bytes) {
+	if(bytes > object_pool_max_size) {
+#if STX_ALLOC_TRACKING
+		_big_tag().on_alloc(bytes);
+#endif
+		return ::operator new(bytes);
+	}
+
+	size_t index = _class_index(bytes);
+#if STX_ALLOC_TRACKING
+	_size_classes()[index].tag->on_alloc(_size_classes()[index].object_size);
+#endif
+	if(local_pool* pool = _local_pool(index)) {
+		return pool->alloc();
+	}
+
+	// The calling thread is exiting: Borrow a slab just for this allocation
+	local_pool temporary;
+	temporary.cls = &_size_classes()[index];
+	void* result = temporary.alloc();
+	temporary.orphan_all();
+	return result;
+}
+
+void pool_free(void* p, size_t bytes) noexcept {
+	if(!p) return;
+
+	if(bytes > object_pool_max_size) {
+#if STX_ALLOC_TRACKING
+		_big_tag().on_free(bytes);
+#endif
+		::operator delete(p);
+		return;
+	}
+
+	size_t index = _class_index(bytes);
+#if STX_ALLOC_TRACKING
+	_size_classes()[index].tag->on_free(_size_classes()[index].object_size);
+#endif
+
+	slab*       s    = _slab_of(p);
+	local_pool* pool = _local_pool(index);
+	if(pool && s->owner.load(std::memory_order_relaxed) == pool) {
+		pool->free_local(p);
+	}
+	else {
+		auto* node = static_cast<free_node*>(p);
+		_push_remote(s, node, node);
+	}
+}
+
+} // namespace stx
@@ -0,0 +1,86 @@
+// Copyright (c) 2017 Benno Straub, licensed under the MIT license. (A copy can be found at the end of this file)
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace stx {
+
+// =============================================================
+// == Object pools =============================================
+// =============================================================
+
+// Pools for small objects of fixed size classes (multiples of 16 bytes, up to object_pool_max_size).
+// Memory comes from 64KiB slabs, which are owned by one thread at a time:
+// - Allocations and frees on the owning thread only touch a thread local free list
+// - Frees from other threads push onto a lock free list of the slab, which the owner collects once its own list runs dry
+// - Slabs of exited threads are adopted by the next thread running out of memory
+// Slabs are never given back to the system, so the pools only grow to the peak number of live objects.
+
+constexpr size_t object_pool_max_size  = 256; //<! Bigger allocations use ::operator new
+constexpr size_t object_pool_alignment = 16;
+
+/// Returns memory for bytes bytes from the pool of bytes' size class, throws std::bad_alloc if out of memory
+void* pool_alloc(size_t bytes);
+/// Gives memory from pool_alloc back, bytes has to be the same value that was passed to pool_alloc. Can be called from any thread.
+void  pool_free(void* p, size_t bytes) noexcept;
+
+template<class T, class... Args>
+T* pool_new(Args&&... args);
+template<class T>
+void pool_delete(T* t) noexcept; //<! t has to be the complete object, i.e. come from pool_new<T>
+
+/// Specialize to true_type to make stx::make_shared<T> allocate from the pools
+template<class T>
+struct use_object_pool : std::false_type {};
+
+/// Base class for objects which should always be allocated from the pools, e.g. per connection state.
+/// Deleting via a base class pointer needs a virtual destructor, as usual.
+struct pooled_object {
+	static void* operator new(size_t bytes) { return pool_alloc(bytes); }
+	static void  operator delete(void* p, size_t bytes) noexcept { pool_free(p, bytes); }
+};
+
+} // namespace stx
+
+// =============================================================
+// == Inline implementation =============================================
+// =============================================================
+
+namespace stx {
+
+template<class T, class... Args>
+T* pool_new(Args&&... args) {
+	static_assert(alignof(T) <= object_pool_alignment, "Type is over aligned for the object pools");
+
+	void* p = pool_alloc(sizeof(T));
+	try {
+		return new(p) T(std::forward<Args>(args)...);
+	}
+	catch(...) {
+		pool_free(p, sizeof(T));
+		throw;
+	}
+}
+
+template<class T>
+void pool_delete(T* t) noexcept {
+	if(!t) return;
+	t->~T();
+	pool_free(t, sizeof(T));
+}
+
+} // namespace stx
+
+/*
+ Copyright (c) 2017 Benno Straub
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -11,6 +11,9 @@
 #include <functional>
 #include <algorithm>
 
+#include "allocation_tracking.hpp"
+#include "object_pool.hpp"
+
 #ifdef STX_SHARED_DEBUG
 #include <typeinfo>
 #include <iosfwd>
@@ -220,8 +223,20 @@ public:
 
 // ** default_shared_block *****************************************************
 
+namespace detail {
+
+struct unpooled_object {};
+
+/// Allocates the blocks of make_shared<T> from the object pools if use_object_pool<T> is specialized
+template<class T>
+using shared_block_storage = std::conditional_t<
+	use_object_pool<std::remove_cv_t<T>>::value && alignof(T) <= object_pool_alignment,
+	pooled_object, unpooled_object>;
+
+} // namespace detail
+
 template<class T>
-class default_shared_block final : public shared_block {
+class default_shared_block final : public shared_block, public detail::shared_block_storage<T> {
 	using Tptr = std::remove_all_extents_t<T>*;
 
 	alignas(T) unsigned char m_data[sizeof(T)];
@@ -232,12 +247,20 @@ public:
 		T* tmp = new(m_data) T(std::forward<Args>(args)...);
 		if(!((unsigned char*)tmp == m_data)) std::terminate();
 		detail::handle_enable_shared_from_this<T, Tptr>(tmp, this);
+#if STX_ALLOC_TRACKING
+		allocation_tag_of<T>().on_alloc(sizeof(*this));
+#endif
 	}
 
 	T* value() noexcept { return (T*) m_data; }
 
 	void shared_block_destroy() noexcept override { value()->~T(); }
-	void shared_block_free() noexcept override { delete this; }
+	void shared_block_free() noexcept override {
+#if STX_ALLOC_TRACKING
+		allocation_tag_of<T>().on_free(sizeof(*this));
+#endif
+		delete this;
+	}
 };
 
 // ** pointer_shared_block *****************************************************
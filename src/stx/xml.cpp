@@ -1,6 +1,7 @@
 #include "xml.hpp"
-
-#include <fstream>
+#include "xml.scan.hpp"
+#include "xml.index.hpp"
+#include "xml.writer.hpp"
 
 #include <cctype>
 #include <cstring>
@@ -10,86 +11,15 @@
 #include <iostream>
 
 #include <array>
+#include <new>
+#include <utility>
 
 namespace stx::xml {
 
-static
-void next_token(const char*& s) {
-	// TODO: conformance
-	while(*s != '\0' && *s <= ' ') {
-		s++;
-	}
-}
-
-static
-bool is_name_character(char c) {
-	constexpr auto lookup = parsing::make_lookup([](char c) {
-		bool is_ws_or_control = c <= ' ';
-		bool is_delete        = c == 127;
-		bool is_special_char  = (c == '>') || (c == '/') || (c == '=');
-
-		return !is_ws_or_control && !is_delete && !is_special_char;
-	});
-
-	return lookup[c];
-}
-
-static
-std::string_view trim_whitespace(std::string_view s) {
-	while(s.size() && std::isspace(s.front())) s.remove_prefix(1);
-	while(s.size() && std::isspace(s.back())) s.remove_suffix(1);
-	return s;
-}
-
-static
-std::string_view parse_name(const char*& s) {
-	// TODO: conformance
-	const char* beg = s;
-	while(is_name_character(*s)) {
-		s++;
-	}
-
-	if(beg == s) {
-		throw errors::parsing_error("Expected valid name", s);
-	}
-
-	return {beg, size_t(s - beg)};
-}
-
-static
-std::string_view parse_literal(const char*& s) {
-	if(*s == '\'') {
-		s++;
-		const char* start = s;
-		while(*s && *s != '\'') s++;
-		if(!*s) {
-			throw errors::parsing_error(
-				"Expected closing single quote ' character",
-				s, { start, 1 }
-			);
-		}
-		auto result = std::string_view(start, size_t(s - start));
-		s++;
-		return result;
-	}
-	else if(*s == '"') {
-		s++;
-		const char* start = s;
-		while(*s && *s != '"') s++;
-		if(!*s) {
-			throw errors::parsing_error(
-				"Expected closing double quote \" character",
-				s, { start, 1 }
-			);
-		}
-		auto result = std::string_view(start, size_t(s - start));
-		s++;
-		return result;
-	}
-	else {
-		throw errors::parsing_error("Expected literal (e.g. 'literal' or \"literal\")", s);
-	}
-}
+using detail::next_token;
+using detail::parse_name;
+using detail::parse_literal;
+using detail::trim_whitespace;
 
 attribute* attribute::next(std::string_view name) noexcept {
 	attribute* n = this;
@@ -129,13 +59,7 @@ attribute& attribute::req_prev(std::string_view name) {
 }
 
 const char* attribute::parse(arena_allocator& alloc, const char* s) {
-	m_name = parse_name(s);
-	if(*s != '=') {
-		m_value = std::string_view();
-		return s;
-	}
-	s++;
-	m_value = parse_literal(s);
+	detail::parse_attribute(s, m_name, m_value);
 	return s;
 }
 
@@ -175,7 +99,31 @@ float attribute::value<float>() const {
 }
 template<>
 std::string attribute::value<std::string>() const {
-	return std::string(this->value());
+	if(!detail::needs_decoding(m_value, true)) return std::string(m_value);
+	std::string result(m_value.size(), '\0');
+	result.resize(detail::decode(m_value, true, result.data()));
+	return result;
+}
+
+/// raw itself if there's nothing to decode, otherwise the decoded copy in arena
+static
+std::string_view const* _decode(arena_allocator& arena, std::string_view const& raw, bool attribute) noexcept {
+	if(!detail::needs_decoding(raw, attribute)) return &raw;
+
+	char* text   = arena.alloc(raw.size());
+	auto* result = reinterpret_cast<std::string_view*>(arena.alloc(sizeof(std::string_view), alignof(std::string_view)));
+	return new(result) std::string_view(text, detail::decode(raw, attribute, text));
+}
+
+std::string_view attribute::decoded_value(arena_allocator& arena) noexcept {
+	if(!m_decoded) m_decoded = _decode(arena, m_value, true);
+	return *m_decoded;
+}
+
+std::string_view node::decoded_content(arena_allocator& arena) noexcept {
+	assert(type() == node_type::content);
+	if(!m_decoded) m_decoded = _decode(arena, m_value, false);
+	return *m_decoded;
 }
 
 bool node::name_in(std::initializer_list<std::string_view> const& names) const noexcept {
@@ -186,6 +134,9 @@ bool node::name_in(std::initializer_list<std::string_view> const& names) const n
 }
 
 node* node::first(std::string_view name) noexcept {
+	if(auto* idx = m_parent ? m_parent->index() : nullptr) {
+		return idx->find(name, name_hash(name), idx->position(this));
+	}
 	node* n = this;
 	do {
 		if(n->type() == regular && n->name() == name)
@@ -194,10 +145,16 @@ node* node::first(std::string_view name) noexcept {
 	return nullptr;
 }
 node* node::next(std::string_view name) noexcept {
+	if(auto* idx = m_parent ? m_parent->index() : nullptr) {
+		return idx->find(name, name_hash(name), idx->position(this) + 1);
+	}
 	if(!next()) return nullptr;
 	return next()->first(name);
 }
 node* node::prev(std::string_view name) noexcept {
+	if(auto* idx = m_parent ? m_parent->index() : nullptr) {
+		return idx->find_before(name, name_hash(name), idx->position(this));
+	}
 	node* n = this;
 	while((n = n->prev())) {
 		if(n->type() == regular && n->name() == name)
@@ -258,6 +215,9 @@ node* node::child(std::initializer_list<std::string_view> const& names) noexcept
 	return children()->first_of(names);
 }
 node* node::child(std::string_view name) noexcept {
+	if(auto* idx = index()) {
+		return idx->find(name, name_hash(name));
+	}
 	if(!children()) return nullptr;
 	return children()->first(name);
 }
@@ -294,6 +254,9 @@ node& node::req_child(std::string_view name) {
 }
 
 attribute* node::attrib(std::string_view name) noexcept {
+	if(auto* idx = index()) {
+		return idx->find_attribute(name, name_hash(name));
+	}
 	attribute* n = attributes();
 	while(n) {
 		if(n->name() == name)
@@ -313,7 +276,23 @@ attribute& node::req_attrib(std::string_view name) {
 	return *result;
 }
 
+detail::node_index const* node::index() noexcept {
+	if(m_index && !m_index->built) {
+		m_index = detail::node_index::build(*this, *m_index->arena);
+	}
+	return m_index;
+}
+
 const char* node::parse_regular(arena_allocator& alloc, const char* s) {
+	bool has_body;
+	s = parse_start_tag(alloc, s, has_body);
+	if(!has_body) return s;
+
+	next_token(s);
+	s = parse_children(alloc, s);
+	return parse_end_tag(s);
+}
+const char* node::parse_start_tag(arena_allocator& alloc, const char* s, bool& has_body) {
 	if(*s != '<')
 		throw errors::parsing_error("Expected opening less-than sign <", s);
 	s++;
@@ -328,21 +307,22 @@ const char* node::parse_regular(arena_allocator& alloc, const char* s) {
 		if(*s != '>') {
 			throw errors::parsing_error("Expected closing greater-than sign >", s, m_value);
 		}
-		return ++s; // No body
+		has_body = false;
+		return ++s;
 	}
 	if(*s != '>') {
 		throw errors::parsing_error("Expected closing greater-than sign >", s, m_value);
 	}
-	s++;
-
-	// Parse body
-	next_token(s);
-	s = parse_children(alloc, s);
-
+	has_body = true;
+	return ++s;
+}
+const char* node::parse_end_tag(const char* s) {
+	if(s[0] != '<' || s[1] != '/')
+		throw errors::parsing_error("Expected closing tag", s, m_value);
 	s += 2;
 
 	if(auto closing_name = parse_name(s); closing_name != m_value)
-		errors::parsing_error("Closing tag doesn't match opening tag", closing_name.data(), m_value.data());
+		throw errors::parsing_error("Closing tag doesn't match opening tag", closing_name.data(), m_value);
 
 	next_token(s);
 	if(*s != '>')
@@ -352,8 +332,7 @@ const char* node::parse_regular(arena_allocator& alloc, const char* s) {
 }
 const char* node::parse_doctype(arena_allocator& alloc, const char* s) {
 	m_type = doctype;
-	while(*s && *s != '>') // HACK, actually parse the thing
-		s++;
+	s = detail::find_char(s, '>'); // HACK, actually parse the thing
 	if(*s != '>')
 		throw errors::parsing_error("Expected closing greater-than sign", s);
 	s++;
@@ -363,8 +342,8 @@ const char* node::parse_comment(arena_allocator& alloc, const char* s) {
 	m_type = comment;
 	s += 4;
 	const char* start = s;
-	while(*s) {
-		if(s[0] == '-' && s[1] == '-' && s[2] == '>') {
+	while(*(s = detail::find_char(s, '-'))) {
+		if(s[1] == '-' && s[2] == '>') {
 			m_value = trim_whitespace({start, size_t(s - start)});
 			return s + 3;
 		}
@@ -397,12 +376,11 @@ const char* node::parse_processing_instruction(arena_allocator& alloc, const cha
 	return s + 2;
 }
 const char* node::parse_content(arena_allocator& alloc, const char* s) {
-	while(*s <= ' ') s++; // Skipws
+	next_token(s);
 	m_type = content;
 	const char* start = s;
-	while(*s && (s[0] != '<' || s[1] <= ' ')) s++;
-	m_value = std::string_view(start, std::max(start, s) - start);
-	while(!m_value.empty() && m_value.back() <= ' ') m_value.remove_suffix(1);
+	s = detail::scan_content(s);
+	m_value = detail::trim_content({start, size_t(s - start)});
 	return s;
 }
 const char* node::parse_attributes(arena_allocator& alloc, const char* s, const char endChar) {
@@ -487,69 +465,76 @@ const char* node::parse_document(arena_allocator& alloc, const char* s) {
 }
 
 void node::print(std::ostream& stream, unsigned indent) {
-	switch(type()) {
-		case node_type::comment: {
-			stream
-			<< std::string(indent * 2, ' ')
-			<< "<!--" << m_value << "-->" << std::endl;
-		} return;
-		case node_type::content: {
-			stream
-			<< std::string(indent * 2, ' ')
-			<< m_value << std::endl;
-		} return;
-		default: {
-			stream
-			<< std::string(indent * 2, ' ')
-			<< '<' << m_value;
-			for(auto* atb = attributes(); atb; atb = atb->next()) {
-				stream
-				<< '\n' << std::string(indent * 2 + 2, ' ')
-				<< atb->name() << "='" << atb->value() << '\'';
-			}
-			if(children()) {
-				stream << ">\n";
-				for(auto* child = children(); child; child = child->next())
-					child->print(stream, indent + 1);
-				stream
-				<< std::string(indent * 2, ' ')
-				<< "</" << m_value << ">\n";
-			}
-			else {
-				stream << "/>\n";
-			}
-		} return;
-	}
-}
-
-static std::string _load_file(std::string_view path) {
-	std::string result;
-
-	// Open file
-	auto file = std::ifstream(std::string(path));
-	if(!file) throw std::runtime_error("Couldn't open file");
-
-	// Get size of file and resize string
-	file.seekg(0, std::ios::end);
-	result.resize(file.tellg());
-	file.seekg(0, std::ios::beg);
-
-	// Read data into string
-	file.read(result.data(), result.size());
-	if(file.gcount() != static_cast<std::streamoff>(result.size()))
-		throw std::runtime_error("Couldn't read full file");
-
-	return result;
+	writer out({ true, 2 });
+	out.write(*this, indent);
+	stream.write(out.view().data(), std::streamsize(out.view().size()));
 }
 
-
 document document::parse(const char* text) {
 	document result;
 	result.parse_document(result.allocator, text);
 	return result;
 }
-document document::load(const char* path) {
-	return document::parse(_load_file(path).c_str());
+document document::load(const char* path, bool map) {
+	document result;
+	result._load(path, map);
+	return result;
+}
+document::document(document&& other) noexcept :
+	node(other),
+	allocator(std::move(other.allocator)),
+	source(std::move(other.source))
+{
+	_take(other);
+}
+document& document::operator=(document&& other) noexcept {
+	if(this != &other) {
+		node::operator=(other);
+		allocator = std::move(other.allocator);
+		source    = std::move(other.source);
+		_take(other);
+	}
+	return *this;
+}
+/// The rest of moving other into this, after the node members were copied and the allocator was moved
+void document::_take(document& other) noexcept {
+	m_pending_index = std::exchange(other.m_pending_index, nullptr);
+	if(m_pending_index) {
+		m_pending_index->arena = &allocator;
+	}
+	for(node* c = m_children; c; c = c->next()) {
+		c->m_parent = this;
+	}
+
+	other.m_attributes = nullptr;
+	other.m_children   = nullptr;
+	other.m_index      = nullptr;
+}
+
+void document::enable_index(size_t min_children) {
+	if(!m_pending_index) {
+		m_pending_index = allocator.create<detail::node_index>();
+		m_pending_index->arena = &allocator;
+	}
+	_enable_index(*this, min_children, m_pending_index);
+}
+void document::_enable_index(node& n, size_t min_children, detail::node_index* pending) {
+	size_t num_children = 0, num_attributes = 0;
+	for(node* c = n.children(); c; c = c->next()) {
+		num_children++;
+		_enable_index(*c, min_children, pending);
+	}
+	for(attribute* a = n.attributes(); a; a = a->next()) {
+		num_attributes++;
+	}
+	if(!n.m_index && std::max(num_children, num_attributes) >= min_children) {
+		n.m_index = pending;
+	}
+}
+
+void document::_load(const char* path, bool map) {
+	source = stx::mapped_file(path, map);
+	parse_document(allocator, source.c_str());
 }
 
 } // namespace stx::xml
@@ -9,6 +9,7 @@
 
 #include "dlist.hpp"
 #include "allocator.hpp"
+#include "mapped_file.hpp"
 #include "parsing.hpp"
 
 #include <exception>
@@ -19,6 +20,10 @@
 
 #include <cassert>
 
+namespace stx {
+class executor;
+}
+
 namespace stx::xml {
 
 namespace errors = ::stx::parsing::errors;
@@ -28,6 +33,10 @@ class node;
 
 class node_iterator;
 
+namespace detail {
+struct node_index;
+}
+
 constexpr inline
 size_t name_hash(std::string_view sv) noexcept;
 
@@ -35,9 +44,16 @@ class attribute : public dlist_element<attribute> {
 public:
 	std::string_view name() const noexcept { return m_name; }
 
+	/// The raw text between the quotes, see decoded_value()
 	template<class T = std::string_view>
 	T value() const { return m_value; }
 
+	/// value() with entity and character references replaced (e.g. &amp; -> &) and tabs and line breaks turned into spaces.
+	/// Decoded into arena (The document's allocator) by the first call, later calls return the same text.
+	/// Values without anything to decode are returned as they are, so well-formed values aren't copied.
+	/// Like index(), not thread safe until the first call.
+	std::string_view decoded_value(arena_allocator& arena) noexcept;
+
 	using dlist_element::next;
 	using dlist_element::prev;
 	attribute* next(std::string_view name) noexcept;
@@ -47,8 +63,9 @@ public:
 
 	const char* parse(arena_allocator& alloc, const char* s);
 private:
-	std::string_view m_name;
-	std::string_view m_value;
+	std::string_view        m_name;
+	std::string_view        m_value;
+	std::string_view const* m_decoded = nullptr; //<! Points to m_value if there's nothing to decode
 };
 
 class node : public dlist_element<node> {
@@ -68,6 +85,10 @@ public:
 	std::string_view cdata_value()   const noexcept { assert(type() == node_type::cdata);  return m_value; }
 	std::string_view comment_value() const noexcept { assert(type() == node_type::comment);return m_value; }
 	std::string_view content_value() const noexcept { assert(type() == node_type::content);return m_value; }
+	std::string_view processing_instruction_name() const noexcept { assert(type() == node_type::processing_instruction); return m_value; }
+
+	/// content_value() with references replaced and line breaks normalized to \n, cached like attribute::decoded_value()
+	std::string_view decoded_content(arena_allocator& arena) noexcept;
 
 	bool name_in(std::initializer_list<std::string_view> const& names) const noexcept;
 
@@ -111,6 +132,9 @@ public:
 	template<class T>
 	T req_attrib(std::string_view name);
 
+	/// Index of children and attributes by name, if document::enable_index() picked this node. Built by the first call.
+	detail::node_index const* index() noexcept;
+
 	// Iterator
 	using iterator = node_iterator;
 	iterator begin(); //<! Iterate over children
@@ -129,6 +153,8 @@ public:
 	// Parsing
 	const char* parse_document(arena_allocator&, const char* cstr);
 	const char* parse_regular(arena_allocator&, const char*);
+	const char* parse_start_tag(arena_allocator&, const char*, bool& has_body);
+	const char* parse_end_tag(const char*);
 	const char* parse_doctype(arena_allocator&, const char*);
 	const char* parse_processing_instruction(arena_allocator&, const char*);
 	const char* parse_comment(arena_allocator&, const char*);
@@ -136,23 +162,65 @@ public:
 	const char* parse_attributes(arena_allocator&, const char*, const char endChar);
 	const char* parse_children(arena_allocator&, const char*);
 	const char* parse_node(arena_allocator&, const char*);
+
+	// Parallel parsing, see document::parse()
+	const char* parse_document(arena_allocator&, const char* cstr, executor& e, size_t num_chunks);
+	const char* parse_regular(arena_allocator&, const char*, executor& e, size_t num_chunks);
+	const char* parse_children(arena_allocator&, const char*, executor& e, size_t num_chunks);
 private:
 	node_type        m_type = node_type::unassigned;
 	std::string_view m_value;
 	attribute*       m_attributes = nullptr;
 	node*            m_parent     = nullptr;
 	node*            m_children   = nullptr;
+
+	std::string_view const* m_decoded = nullptr; //<! See decoded_content()
+
+	friend class document;
+	detail::node_index* m_index = nullptr; //<! Might still be the document's pending index
 };
 
 class document : public xml::node {
 public:
+	/// text has to outlive the document, since nodes point into it
 	static document parse(const char* text);
-	static document load(const char* path);
+	/// Maps the file into memory (or reads it, if map is false), the document keeps it alive
+	static document load(const char* path, bool map = true);
+
+	/// Same result as parse(text), but the children of the root element are parsed in parallel on e,
+	/// in up to num_chunks chunks (0: One per hardware thread) of at least parallel_min_chunk_size bytes each.
+	/// Chunks start at the first tag after evenly spaced offsets. A chunk which turns out to have started inside
+	/// another element (e.g. a root element with few big children) is parsed again serially, so that's slower than parse().
+	static document parse(const char* text, executor& e, size_t num_chunks = 0);
+	static document load(const char* path, executor& e, size_t num_chunks = 0, bool map = true);
+
+	static constexpr size_t parallel_min_chunk_size = 256 * 1024;
+
+	/// Makes the lookups by name (child(), first(), next(), prev() and attrib()) among the children and attributes of nodes
+	/// which have at least min_children of either use a hash index instead of walking the list.
+	/// The index is built on the first lookup and stored in the allocator, so lookups aren't thread safe anymore until then.
+	/// See the xml benchmark for where an index starts paying off.
+	void enable_index(size_t min_children = default_index_min_children);
+
+	static constexpr size_t default_index_min_children = 16;
 
 	stx::arena_allocator allocator;
+	stx::mapped_file     source; //<! Text of documents from load()
 
 	document() {}
-	document(std::string const& path) { load(path.c_str()); }
+	document(std::string const& path) { _load(path.c_str(), true); }
+
+	/// The top level nodes and the pending index point back to the document and its allocator, so moving updates them.
+	/// The moved from document is empty.
+	document(document&& other) noexcept;
+	document& operator=(document&& other) noexcept;
+
+private:
+	void _load(const char* path, bool map);
+	void _enable_index(node& n, size_t min_children, detail::node_index* pending);
+	void _take(document& other) noexcept;
+
+	detail::node_index* m_pending_index = nullptr; //<! Lives in allocator, see enable_index()
 };
 
 } // namespace stx::xml
@@ -196,6 +264,7 @@ template<>
 float attribute::value<float>() const;
 template<>
 double attribute::value<double>() const;
+/// Decoded like decoded_value(), into the string instead of the arena
 template<>
 std::string attribute::value<std::string>() const;
 
@@ -0,0 +1,145 @@
+#include "xml.index.hpp"
+
+#include <algorithm>
+
+namespace stx::xml::detail {
+
+/// Power of two with at least twice as many slots as entries, so probe sequences stay short
+static
+size_t _table_size(size_t entries) noexcept {
+	size_t size = 4;
+	while(size < entries * 2) size *= 2;
+	return size;
+}
+
+static
+size_t _pointer_hash(void const* p) noexcept {
+	// Nodes are at least 8 byte aligned, Fibonacci hashing mixes the remaining bits into the top ones
+	uint64_t h = (uint64_t(uintptr_t(p)) >> 3) * 11400714819323198485ull;
+	return size_t(h ^ (h >> 32));
+}
+
+template<class T>
+static
+T* _create_table(arena_allocator& arena, size_t size) noexcept {
+	T* result = reinterpret_cast<T*>(arena.alloc(sizeof(T) * size, alignof(T)));
+	std::fill(result, result + size, T{});
+	return result;
+}
+
+node_index* node_index::build(node& n, arena_allocator& arena) noexcept {
+	node_index* result = arena.create<node_index>();
+	result->built = true;
+
+	size_t num_children = 0, num_regular = 0, num_attributes = 0;
+	for(node* c = n.children(); c; c = c->next()) {
+		num_children++;
+		if(c->type() == node::regular) num_regular++;
+	}
+	for(attribute* a = n.attributes(); a; a = a->next()) {
+		num_attributes++;
+	}
+
+	size_t names_size      = _table_size(num_regular);
+	size_t positions_size  = _table_size(num_children);
+	size_t attributes_size = _table_size(num_attributes);
+	result->names           = _create_table<name_slot>(arena, names_size);
+	result->names_mask      = names_size - 1;
+	result->named           = _create_table<named_child>(arena, std::max<size_t>(num_regular, 1));
+	result->positions       = _create_table<position_slot>(arena, positions_size);
+	result->positions_mask  = positions_size - 1;
+	result->attributes      = _create_table<attribute_slot>(arena, attributes_size);
+	result->attributes_mask = attributes_size - 1;
+
+	// Count the children of each name, then give each name a range of named in order of first appearance
+	for(node* c = n.children(); c; c = c->next()) {
+		if(c->type() != node::regular) continue;
+		name_slot* slot = result->group(c->name(), name_hash(c->name()));
+		if(!slot->first) {
+			slot->hash  = name_hash(c->name());
+			slot->first = c;
+		}
+		slot->count++;
+	}
+	uint32_t begin = 0;
+	for(size_t i = 0; i < names_size; i++) {
+		name_slot& slot = result->names[i];
+		slot.begin = begin;
+		begin     += slot.count;
+		slot.count = 0;
+	}
+
+	uint32_t position = 0;
+	for(node* c = n.children(); c; c = c->next(), position++) {
+		size_t i = _pointer_hash(c) & result->positions_mask;
+		while(result->positions[i].child) i = (i + 1) & result->positions_mask;
+		result->positions[i] = { c, position };
+
+		if(c->type() == node::regular) {
+			name_slot* slot = result->group(c->name(), name_hash(c->name()));
+			result->named[slot->begin + slot->count++] = { position, c };
+		}
+	}
+
+	for(attribute* a = n.attributes(); a; a = a->next()) {
+		size_t hash = name_hash(a->name());
+		size_t i    = hash & result->attributes_mask;
+		while(result->attributes[i].first && !(result->attributes[i].hash == hash && result->attributes[i].first->name() == a->name())) {
+			i = (i + 1) & result->attributes_mask;
+		}
+		if(!result->attributes[i].first) {
+			result->attributes[i] = { hash, a };
+		}
+	}
+
+	return result;
+}
+
+node_index::name_slot* node_index::group(std::string_view name, size_t hash) const noexcept {
+	size_t i = hash & names_mask;
+	while(names[i].first && !(names[i].hash == hash && names[i].first->name() == name)) {
+		i = (i + 1) & names_mask;
+	}
+	return &names[i];
+}
+
+uint32_t node_index::position(node const* child) const noexcept {
+	size_t i = _pointer_hash(child) & positions_mask;
+	while(positions[i].child != child) {
+		i = (i + 1) & positions_mask;
+	}
+	return positions[i].position;
+}
+
+node* node_index::find(std::string_view name, size_t hash, uint32_t position) const noexcept {
+	name_slot const* slot = group(name, hash);
+	if(!slot->first) return nullptr;
+
+	named_child const* begin = named + slot->begin;
+	named_child const* end   = begin + slot->count;
+	if(position == 0) return begin->child;
+
+	auto* found = std::lower_bound(begin, end, position, [](named_child const& c, uint32_t p) { return c.position < p; });
+	return found != end ? found->child : nullptr;
+}
+
+node* node_index::find_before(std::string_view name, size_t hash, uint32_t position) const noexcept {
+	name_slot const* slot = group(name, hash);
+	if(!slot->first) return nullptr;
+
+	named_child const* begin = named + slot->begin;
+	named_child const* end   = begin + slot->count;
+	auto* found = std::lower_bound(begin, end, position, [](named_child const& c, uint32_t p) { return c.position < p; });
+	return found != begin ? (found - 1)->child : nullptr;
+}
+
+attribute* node_index::find_attribute(std::string_view name, size_t hash) const noexcept {
+	size_t i = hash & attributes_mask;
+	while(attributes[i].first) {
+		if(attributes[i].hash == hash && attributes[i].first->name() == name) return attributes[i].first;
+		i = (i + 1) & attributes_mask;
+	}
+	return nullptr;
+}
+
+} // namespace stx::xml::detail
@@ -0,0 +1,63 @@
+// Internal: Hashed index of a node's children and attributes, see document::enable_index()
+
+#pragma once
+
+#include "xml.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+namespace stx::xml::detail {
+
+/// Lives in the document's arena. Until a node is first searched, it points to the document's pending index,
+/// which only knows the arena to build the real one in.
+struct node_index {
+	/// Children with the same name, in document order
+	struct name_slot {
+		size_t   hash;
+		node*    first; //<! nullptr: Empty slot
+		uint32_t begin; //<! Into named
+		uint32_t count;
+	};
+	struct named_child {
+		uint32_t position; //<! Among all children
+		node*    child;
+	};
+	struct position_slot {
+		node const* child; //<! nullptr: Empty slot
+		uint32_t    position;
+	};
+	struct attribute_slot {
+		size_t     hash;
+		attribute* first; //<! nullptr: Empty slot
+	};
+
+	arena_allocator* arena = nullptr; //<! Only set for the pending index
+	bool             built = false;
+
+	name_slot*      names          = nullptr;
+	size_t          names_mask     = 0;
+	named_child*    named          = nullptr;
+	position_slot*  positions      = nullptr;
+	size_t          positions_mask = 0;
+	attribute_slot* attributes     = nullptr;
+	size_t          attributes_mask = 0;
+
+	static node_index* build(node& n, arena_allocator& arena) noexcept;
+
+	/// Position of child among all children of the indexed node
+	uint32_t position(node const* child) const noexcept;
+
+	/// First regular child named name at or after position (e.g. position(n) + 1 for n->next(name)), or nullptr
+	node* find(std::string_view name, size_t hash, uint32_t position = 0) const noexcept;
+	/// Last regular child named name before position, or nullptr
+	node* find_before(std::string_view name, size_t hash, uint32_t position) const noexcept;
+
+	/// First attribute named name, or nullptr
+	attribute* find_attribute(std::string_view name, size_t hash) const noexcept;
+
+	/// Slot of name, or the empty slot where it would go
+	name_slot* group(std::string_view name, size_t hash) const noexcept;
+};
+
+} // namespace stx::xml::detail
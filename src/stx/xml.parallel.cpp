@@ -0,0 +1,173 @@
+#include "xml.hpp"
+#include "xml.scan.hpp"
+
+#include "async/parallel.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace stx::xml {
+
+using detail::next_token;
+
+namespace {
+
+/// Children of one node parsed from [begin, limit), the last one might end after limit
+struct chunk {
+	const char*        begin;
+	const char*        limit;
+	const char*        end   = nullptr; //<! Where parsing stopped, the next chunk is valid if it begins right there
+	node*              first = nullptr;
+	node*              last  = nullptr;
+	arena_allocator    arena;
+	std::exception_ptr error;
+};
+
+} // namespace
+
+/// First start tag at or after s (Not a closing tag, comment, etc.), or the terminating '\0'
+static
+const char* _next_start_tag(const char* s) noexcept {
+	while(*(s = detail::find_char(s, '<'))) {
+		char c = s[1];
+		if(c > ' ' && c != '/' && c != '!' && c != '?') return s;
+		s++;
+	}
+	return s;
+}
+
+const char* node::parse_children(arena_allocator& alloc, const char* s, executor& e, size_t num_chunks) {
+	next_token(s);
+
+	if(num_chunks == 0) num_chunks = std::max(1u, std::thread::hardware_concurrency());
+	size_t length = std::strlen(s);
+	num_chunks = std::min(num_chunks, length / document::parallel_min_chunk_size);
+	if(num_chunks <= 1) {
+		return parse_children(alloc, s);
+	}
+
+	// Chunks start at the first tag after evenly spaced offsets, which doesn't have to be a child of this node
+	std::vector<chunk> chunks(num_chunks);
+	const char* end = s + length;
+	for(size_t i = 0; i < num_chunks; i++) {
+		chunks[i].begin = (i == 0) ? s : std::max(chunks[i - 1].begin, _next_start_tag(s + length / num_chunks * i));
+		if(i > 0) chunks[i - 1].limit = chunks[i].begin;
+	}
+	chunks.back().limit = end;
+
+	// Same as the loop in parse_children(alloc, s), but stops at the chunk's limit
+	auto parse_chunk = [this](arena_allocator& alloc, chunk& c) {
+		const char* s = c.begin;
+		while(s < c.limit && *s && !(s[0] == '<' && s[1] == '/')) {
+			node* n = alloc.create<node>();
+			s = n->parse_node(alloc, s);
+			n->m_parent = this;
+			if(c.last) c.last->append_list(n);
+			else       c.first = n;
+			c.last = n;
+			next_token(s);
+		}
+		c.end = s;
+	};
+
+	// Speculatively parse all chunks at once. Errors only matter for chunks which turn out to be valid.
+	parallel_for(e, 0, num_chunks, 1, [&](size_t i) {
+		chunk& c = chunks[i];
+		try {
+			parse_chunk(c.arena, c);
+		}
+		catch(...) {
+			c.error = std::current_exception();
+		}
+	});
+
+	// A chunk is valid if the one before it ended right where it begins, otherwise the last child
+	// of the chunk before extends into it, and whatever comes after that is parsed serially.
+	const char* expected = s;
+	node*       last     = nullptr;
+	for(chunk& c : chunks) {
+		if(c.begin != expected) {
+			chunk serial;
+			serial.begin = expected;
+			serial.limit = std::max(expected, c.limit);
+			parse_chunk(alloc, serial);
+			c.first = serial.first;
+			c.last  = serial.last;
+			c.end   = serial.end;
+		}
+		else {
+			if(c.error) std::rethrow_exception(c.error);
+			alloc.adopt(std::move(c.arena));
+		}
+
+		if(c.first) {
+			if(last) last->append_list(c.first);
+			else     m_children = c.first;
+			last = c.last;
+		}
+
+		// Reached the closing tag (Or the end of the text), the remaining chunks are after it
+		expected = c.end;
+		if(!*expected || (expected[0] == '<' && expected[1] == '/')) break;
+	}
+	return expected;
+}
+
+const char* node::parse_regular(arena_allocator& alloc, const char* s, executor& e, size_t num_chunks) {
+	bool has_body;
+	s = parse_start_tag(alloc, s, has_body);
+	if(!has_body) return s;
+
+	next_token(s);
+	s = parse_children(alloc, s, e, num_chunks);
+	return parse_end_tag(s);
+}
+
+const char* node::parse_document(arena_allocator& alloc, const char* s, executor& e, size_t num_chunks) {
+	next_token(s);
+	if(*s != '<') {
+		throw errors::parsing_error(
+			"Expected entity (e.g. <entity/>), "
+			"comment (e.g <!-- Comment -->) or "
+			"doctype declaration <!DOCTYPE>", s);
+	}
+
+	// Like parse_children(), but parses the root element in parallel
+	const char* begin = s;
+	node*       last  = nullptr;
+	bool        root  = false;
+	while(*s && !(s[0] == '<' && s[1] == '/')) {
+		node* n = alloc.create<node>();
+		if(!root && s[0] == '<' && s[1] != '!' && s[1] != '?') {
+			s = n->parse_regular(alloc, s, e, num_chunks);
+			root = true;
+		}
+		else {
+			s = n->parse_node(alloc, s);
+		}
+		n->m_parent = this;
+		if(last) last->append_list(n);
+		else     m_children = n;
+		last = n;
+		next_token(s);
+	}
+
+	return begin;
+}
+
+document document::parse(const char* text, executor& e, size_t num_chunks) {
+	document result;
+	result.parse_document(result.allocator, text, e, num_chunks);
+	return result;
+}
+document document::load(const char* path, executor& e, size_t num_chunks, bool map) {
+	document result;
+	result.source = stx::mapped_file(path, map);
+	result.parse_document(result.allocator, result.source.c_str(), e, num_chunks);
+	return result;
+}
+
+} // namespace stx::xml
@@ -0,0 +1,267 @@
+#include "xml.pull.hpp"
+#include "xml.scan.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#if __has_include(<unistd.h>)
+	#include <unistd.h>
+#endif
+
+namespace stx::xml {
+
+using detail::errors::parsing_error;
+
+// ** Ends of units *******************************************************
+
+// Each returns the end of the unit starting at s, or nullptr if the buffer ends before it
+
+static
+const char* _tag_end(const char* s) {
+	char quote = 0;
+	for(s++; *s; s++) {
+		if(quote) {
+			if(*s == quote) quote = 0;
+		}
+		else if(*s == '"' || *s == '\'') {
+			quote = *s;
+		}
+		else if(*s == '>') {
+			return s + 1;
+		}
+	}
+	return nullptr;
+}
+
+static
+const char* _comment_end(const char* s) {
+	for(s += 4; *(s = detail::find_char(s, '-')); s++) {
+		if(s[1] == '-' && s[2] == '>') return s + 3;
+	}
+	return nullptr;
+}
+
+static
+const char* _processing_instruction_end(const char* s) {
+	for(s += 2; *(s = detail::find_char(s, '?')); s++) {
+		if(s[1] == '>') return s + 2;
+	}
+	return nullptr;
+}
+
+static
+const char* _declaration_end(const char* s) {
+	s = detail::find_char(s, '>'); // Like node::parse_doctype()
+	return *s ? s + 1 : nullptr;
+}
+
+static
+const char* _text_end(const char* s) {
+	s = detail::scan_content(s);
+	return *s ? s : nullptr;
+}
+
+// =============================================================
+// == pull_parser =============================================
+// =============================================================
+
+pull_parser::pull_parser(read_fn read, size_t chunk_size) :
+	m_read(std::move(read)),
+	m_chunk_size(std::max<size_t>(chunk_size, 16))
+{}
+
+pull_parser::read_fn pull_parser::read_fd(int fd) {
+#if __has_include(<unistd.h>)
+	return [fd](char* buffer, size_t size) -> size_t {
+		while(true) {
+			ssize_t n = ::read(fd, buffer, size);
+			if(n >= 0) return size_t(n);
+			if(errno != EINTR) throw std::runtime_error("Failed reading xml input: " + std::string(std::strerror(errno)));
+		}
+	};
+#else
+	throw std::runtime_error("pull_parser::read_fd() isn't supported on this platform");
+#endif
+}
+
+pull_parser::read_fn pull_parser::read_string(std::string_view text) {
+	return [text](char* buffer, size_t size) mutable -> size_t {
+		size_t n = std::min(size, text.size());
+		std::memcpy(buffer, text.data(), n);
+		text.remove_prefix(n);
+		return n;
+	};
+}
+
+bool pull_parser::fill() {
+	if(m_eof) return false;
+
+	// Move the unconsumed input to the front, so the buffer only has to fit one unit
+	size_t rest = m_end - m_pos;
+	if(m_pos > 0) {
+		std::memmove(m_buffer.get(), pos(), rest);
+		m_pos = 0;
+		m_end = rest;
+	}
+
+	if(m_capacity < m_end + m_chunk_size / 2 + 1) {
+		size_t capacity = std::max(m_capacity * 2, m_end + m_chunk_size + 1);
+		auto   buffer   = std::make_unique<char[]>(capacity);
+		if(m_buffer) std::memcpy(buffer.get(), m_buffer.get(), m_end);
+		m_buffer   = std::move(buffer);
+		m_capacity = capacity;
+	}
+
+	size_t n = m_read(m_buffer.get() + m_end, m_capacity - 1 - m_end);
+	m_end += n;
+	m_buffer[m_end] = '\0';
+	if(n == 0) m_eof = true;
+
+	return n > 0;
+}
+
+size_t pull_parser::require(const char* (*find_end)(const char* begin), bool accept_end_of_input) {
+	while(true) {
+		if(m_buffer) {
+			if(const char* end = find_end(pos())) return size_t(end - m_buffer.get());
+			if(std::memchr(pos(), '\0', m_end - m_pos)) {
+				throw parsing_error("Unexpected '\\0' in xml input", pos());
+			}
+		}
+		if(!fill()) {
+			if(accept_end_of_input) return m_end;
+			throw parsing_error("Unexpected end of xml input", pos());
+		}
+	}
+}
+
+pull_parser::event_type pull_parser::next() {
+	if(m_next_attribute < m_attributes.size()) {
+		auto& a = m_attributes[m_next_attribute++];
+		m_name  = a.name;
+		m_value = a.value;
+		return m_type = attribute;
+	}
+	m_attributes.clear();
+	m_next_attribute = 0;
+
+	if(m_close_empty) {
+		m_close_empty = false;
+		m_closed = std::move(m_open.back());
+		m_open.pop_back();
+		m_name  = m_closed;
+		m_value = {};
+		return m_type = end_element;
+	}
+
+	while(m_buffer || fill()) {
+		m_pos = size_t(detail::skip_whitespace(pos()) - m_buffer.get());
+		if(m_pos == m_end) {
+			if(!fill()) break;
+			continue;
+		}
+
+		const char* s = pos();
+		if(*s == '\0') {
+			throw parsing_error("Unexpected '\\0' in xml input", s);
+		}
+		if(*s != '<') {
+			return parse_text();
+		}
+
+		// Enough characters to tell what kind of markup this is
+		while(m_end - m_pos < 4 && fill());
+		s = pos();
+
+		if(s[1] == '!' || s[1] == '?') {
+			skip_markup();
+			continue;
+		}
+		if(s[1] == '/') {
+			return parse_end_tag();
+		}
+		return parse_start_tag();
+	}
+
+	if(!m_open.empty()) {
+		throw parsing_error("Unexpected end of xml input, expected closing tag for '" + m_open.back() + "'");
+	}
+	m_name  = {};
+	m_value = {};
+	return m_type = end_of_document;
+}
+
+void pull_parser::skip_markup() {
+	const char* s = pos();
+	if(s[1] == '?') {
+		m_pos = require(_processing_instruction_end, false);
+	}
+	else if(s[2] == '-' && s[3] == '-') {
+		m_pos = require(_comment_end, false);
+	}
+	else {
+		m_pos = require(_declaration_end, false);
+	}
+}
+
+pull_parser::event_type pull_parser::parse_start_tag() {
+	require(_tag_end, false);
+
+	const char* s = pos() + 1;
+	m_name = detail::parse_name(s);
+
+	detail::next_token(s);
+	while(*s != '/' && *s != '>') {
+		attribute_view a;
+		detail::parse_attribute(s, a.name, a.value);
+		m_attributes.push_back(a);
+		detail::next_token(s);
+	}
+	if(*s == '/') {
+		s++;
+		if(*s != '>') {
+			throw parsing_error("Expected closing greater-than sign >", s, m_name);
+		}
+		m_close_empty = true;
+	}
+	s++;
+
+	m_open.emplace_back(m_name);
+	m_pos   = size_t(s - m_buffer.get());
+	m_value = {};
+	return m_type = start_element;
+}
+
+pull_parser::event_type pull_parser::parse_end_tag() {
+	require(_tag_end, false);
+
+	const char* s = pos() + 2;
+	std::string_view name = detail::parse_name(s);
+	detail::next_token(s);
+	if(*s != '>') {
+		throw parsing_error("Expected closing greater-than sign >", s);
+	}
+	if(m_open.empty() || m_open.back() != name) {
+		throw parsing_error("Closing tag doesn't match opening tag", name.data());
+	}
+
+	m_closed = std::move(m_open.back());
+	m_open.pop_back();
+	m_pos   = size_t(s + 1 - m_buffer.get());
+	m_name  = m_closed;
+	m_value = {};
+	return m_type = end_element;
+}
+
+pull_parser::event_type pull_parser::parse_text() {
+	size_t end = require(_text_end, true);
+
+	m_value = detail::trim_content({pos(), end - m_pos});
+	m_name  = {};
+	m_pos   = end;
+	return m_type = text;
+}
+
+} // namespace stx::xml
@@ -0,0 +1,101 @@
+// Copyright (c) 2017 Benno Straub, licensed under the MIT license. (A copy can be found at the end of this file)
+
+#pragma once
+
+#include "parsing.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stx::xml {
+
+/// Reads a document one event at a time, without building a DOM:
+///
+///   stx::xml::pull_parser parser(stx::xml::pull_parser::read_fd(fd));
+///   while(parser.next() != pull_parser::end_of_document) {
+///       if(parser.type() == pull_parser::start_element && parser.name() == "entry") ...
+///   }
+///
+/// Input is read in chunks, the buffer only grows to fit the biggest single tag or text,
+/// so memory doesn't depend on the document's size. Comments, processing instructions and doctypes are skipped.
+/// Uses the same tokenizer as node::parse_document(), so names, attributes and text come out the same.
+class pull_parser {
+public:
+	enum event_type {
+		start_element,   //<! name(), followed by one attribute event per attribute
+		attribute,       //<! name() and value()
+		text,            //<! value(), whitespace trimmed like xml::node's content
+		end_element,     //<! name(), also sent for empty elements like <name/>
+		end_of_document
+	};
+
+	/// Reads up to size bytes into buffer, returns the number of bytes read (0 at the end of the input)
+	using read_fn = std::function<size_t(char* buffer, size_t size)>;
+
+	explicit pull_parser(read_fn read, size_t chunk_size = 64 * 1024);
+	pull_parser(pull_parser&&) = default;
+	pull_parser& operator=(pull_parser&&) = default;
+
+	/// Reads from a file descriptor (POSIX only), which has to stay open while parsing
+	static read_fn read_fd(int fd);
+	/// Reads from text in memory, in chunks like any other input (e.g. for tests)
+	static read_fn read_string(std::string_view text);
+
+	/// Advances to the next event. Throws parsing::errors::parsing_error on malformed input.
+	/// name() and value() of the previous event are invalidated.
+	event_type next();
+
+	event_type       type()  const noexcept { return m_type; }
+	std::string_view name()  const noexcept { return m_name; }
+	std::string_view value() const noexcept { return m_value; }
+	size_t           depth() const noexcept { return m_open.size(); } //<! Number of open elements, the current one included
+
+	size_t buffer_capacity() const noexcept { return m_capacity; } //<! Grows with the biggest tag or text
+
+private:
+	struct attribute_view {
+		std::string_view name;
+		std::string_view value;
+	};
+
+	const char* pos() const noexcept { return m_buffer.get() + m_pos; }
+	bool        fill(); //<! Reads more input after the unconsumed part, returns false at the end of the input
+	size_t      require(const char* (*find_end)(const char* begin), bool accept_end_of_input); //<! Offset of the end of the unit at pos(), reads until it's found
+	void        skip_markup();
+
+	event_type parse_start_tag();
+	event_type parse_end_tag();
+	event_type parse_text();
+
+	read_fn                 m_read;
+	size_t                  m_chunk_size;
+	std::unique_ptr<char[]> m_buffer;
+	size_t                  m_capacity = 0; //<! Always leaves room for the terminating '\0'
+	size_t                  m_pos      = 0; //<! Unconsumed input starts here
+	size_t                  m_end      = 0;
+	bool                    m_eof      = false;
+
+	event_type                  m_type = end_of_document;
+	std::string_view            m_name;
+	std::string_view            m_value;
+	std::vector<attribute_view> m_attributes;      //<! Of the last start tag, point into the buffer
+	size_t                      m_next_attribute = 0;
+	bool                        m_close_empty    = false; //<! Last start tag was <name/>
+	std::vector<std::string>    m_open;            //<! Names of all open elements
+	std::string                 m_closed;          //<! Name of the element end_element is for
+};
+
+} // namespace stx::xml
+
+/*
+ Copyright (c) 2017 Benno Straub
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,290 @@
+#include "xml.query.hpp"
+#include "xml.index.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace stx::xml {
+
+// ** Compiling *******************************************************
+
+namespace {
+
+struct query_parser {
+	std::string const& expression;
+	const char*        s;
+
+	errors::parsing_error error(std::string message) const {
+		// The expression doesn't outlive the query, so the location is part of the message
+		return errors::parsing_error(
+			message + " at offset " + std::to_string(s - expression.c_str()) + " of query '" + expression + "'"
+		);
+	}
+
+	void skip_whitespace() noexcept {
+		while(*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r') s++;
+	}
+
+	std::string name() {
+		const char* begin = s;
+		while(*s && !std::strchr(" \t\r\n/[]=@'\"*|(),", *s)) s++;
+		if(s == begin) throw error("Expected a name");
+		return std::string(begin, s);
+	}
+};
+
+} // namespace
+
+query::query(std::string_view expression) :
+	m_expression(expression)
+{
+	query_parser p { m_expression, m_expression.c_str() };
+
+	step::kind_t kind = step::child;
+	if(*p.s == '/') {
+		m_absolute = true;
+		kind = (p.s[1] == '/') ? step::descendant : step::child;
+		p.s += (p.s[1] == '/') ? 2 : 1;
+	}
+
+	while(true) {
+		step current;
+		current.kind = kind;
+
+		if(*p.s == '.') {
+			if(p.s[1] == '.') throw p.error("The parent step '..' isn't supported");
+			if(kind == step::descendant) throw p.error("Expected a name or '*' after '//'");
+			current.kind = step::self;
+			p.s++;
+		}
+		else if(*p.s == '*') {
+			current.any_name = true;
+			p.s++;
+		}
+		else {
+			current.name = p.name();
+			current.hash = name_hash(current.name);
+		}
+
+		while(current.kind != step::self && *p.s == '[') {
+			p.s++;
+			p.skip_whitespace();
+
+			predicate pred;
+			if(std::isdigit((unsigned char) *p.s)) {
+				pred.kind = predicate::position;
+				while(std::isdigit((unsigned char) *p.s)) {
+					pred.index = pred.index * 10 + uint32_t(*p.s++ - '0');
+				}
+				if(pred.index == 0) throw p.error("Positions start at 1");
+			}
+			else if(*p.s == '@') {
+				p.s++;
+				pred.kind = predicate::has_attribute;
+				pred.name = p.name();
+				pred.hash = name_hash(pred.name);
+
+				p.skip_whitespace();
+				if(*p.s == '=') {
+					p.s++;
+					p.skip_whitespace();
+
+					char quote = *p.s;
+					if(quote != '\'' && quote != '"') throw p.error("Expected a quoted value");
+					const char* begin = ++p.s;
+					while(*p.s && *p.s != quote) p.s++;
+					if(!*p.s) throw p.error("Expected closing quote");
+					pred.kind  = predicate::attribute_equals;
+					pred.value = std::string(begin, p.s++);
+				}
+			}
+			else {
+				throw p.error("Expected a position or an attribute (e.g. [2] or [@name='value'])");
+			}
+
+			p.skip_whitespace();
+			if(*p.s != ']') throw p.error("Expected closing bracket ]");
+			p.s++;
+
+			if(current.predicates.size() == max_predicates) throw p.error("Too many predicates");
+			current.predicates.push_back(std::move(pred));
+		}
+
+		m_steps.push_back(std::move(current));
+
+		if(!*p.s) break;
+		if(*p.s != '/') throw p.error("Expected '/'");
+		kind = (p.s[1] == '/') ? step::descendant : step::child;
+		p.s += (p.s[1] == '/') ? 2 : 1;
+	}
+}
+
+// ** Evaluating *******************************************************
+
+node* query::first(node& context) const {
+	node* result = nullptr;
+	each(context, [&](node& n) {
+		result = &n;
+		return false;
+	});
+	return result;
+}
+
+size_t query::count(node& context) const {
+	size_t result = 0;
+	each(context, [&](node&) { result++; });
+	return result;
+}
+
+bool query::_each(node& context, match_fn fn, void* fn_context) const {
+	node* start = &context;
+	if(m_absolute) {
+		while(start->parent()) start = start->parent();
+	}
+	return _prefix(0, *start, fn, fn_context);
+}
+
+bool query::_prefix(size_t i, node& n, match_fn fn, void* fn_context) const {
+	if(i == m_steps.size()) {
+		return fn(fn_context, n);
+	}
+	step const& s = m_steps[i];
+	if(s.kind == step::self) {
+		return _prefix(i + 1, n, fn, fn_context);
+	}
+	if(s.kind == step::descendant) {
+		return _descendants(i, n, n, fn, fn_context);
+	}
+
+	uint32_t counters[max_predicates] = {}; //<! Candidates which got to each position predicate
+	bool     exhausted = false;             //<! A position predicate can't match anymore
+
+	// Only visit the children with the right name
+	if(!s.any_name) {
+		if(auto* idx = n.index()) {
+			auto* group = idx->group(s.name, s.hash);
+			if(!group->first) return true;
+
+			// Children with the right name are contiguous, so a leading position can be looked up directly
+			uint32_t k = group->begin;
+			if(!s.predicates.empty() && s.predicates[0].kind == predicate::position) {
+				k += s.predicates[0].index - 1;
+				counters[0] = s.predicates[0].index - 1;
+			}
+			for(; k < group->begin + group->count && !exhausted; k++) {
+				node* c = idx->named[k].child;
+				if(_test(s, *c, counters, exhausted) && !_prefix(i + 1, *c, fn, fn_context)) return false;
+			}
+			return true;
+		}
+	}
+
+	for(node* c = n.children(); c && !exhausted; c = c->next()) {
+		if(_test(s, *c, counters, exhausted) && !_prefix(i + 1, *c, fn, fn_context)) return false;
+	}
+	return true;
+}
+
+bool query::_descendants(size_t first, node& anchor, node& parent, match_fn fn, void* fn_context) const {
+	for(node* c = parent.children(); c; c = c->next()) {
+		if(_match_up(first, m_steps.size() - 1, *c, anchor) && !fn(fn_context, *c)) return false;
+		if(c->children() && !_descendants(first, anchor, *c, fn, fn_context)) return false;
+	}
+	return true;
+}
+
+bool query::_match_up(size_t first, size_t i, node& n, node& anchor) const noexcept {
+	step const& s = m_steps[i];
+	if(s.kind == step::self) {
+		// first is a descendant step, so there's always a step before this one
+		return &n != &anchor && _match_up(first, i - 1, n, anchor);
+	}
+	if(!_test_at(s, n, s.predicates.size())) return false;
+
+	node* p = n.parent();
+	if(s.kind == step::child) {
+		if(!p) return false;
+		return i == first ? p == &anchor : (p != &anchor && _match_up(first, i - 1, *p, anchor));
+	}
+
+	// Descendant step: Any ancestor up to the anchor can match the previous step
+	for(; p; p = p->parent()) {
+		if(p == &anchor) return i == first;
+		if(i > first && _match_up(first, i - 1, *p, anchor)) return true;
+	}
+	return false;
+}
+
+bool query::_test(step const& s, node& n, uint32_t* counters, bool& exhausted) const noexcept {
+	if(n.type() != node::regular) return false;
+	if(!s.any_name && n.name() != s.name) return false;
+
+	for(size_t k = 0; k < s.predicates.size(); k++) {
+		predicate const& p = s.predicates[k];
+		switch(p.kind) {
+			case predicate::position: {
+				if(++counters[k] != p.index) {
+					exhausted |= counters[k] > p.index;
+					return false;
+				}
+			} break;
+			case predicate::has_attribute:
+			case predicate::attribute_equals: {
+				if(!_test_attribute(p, n)) return false;
+			} break;
+		}
+	}
+	return true;
+}
+
+bool query::_test_at(step const& s, node& n, size_t num_predicates) const noexcept {
+	if(n.type() != node::regular) return false;
+	if(!s.any_name && n.name() != s.name) return false;
+
+	for(size_t k = 0; k < num_predicates; k++) {
+		predicate const& p = s.predicates[k];
+		switch(p.kind) {
+			case predicate::position: {
+				if(_position(s, n, k) != p.index) return false;
+			} break;
+			case predicate::has_attribute:
+			case predicate::attribute_equals: {
+				if(!_test_attribute(p, n)) return false;
+			} break;
+		}
+	}
+	return true;
+}
+
+uint32_t query::_position(step const& s, node& n, size_t k) const noexcept {
+	uint32_t limit = s.predicates[k].index;
+
+	// Children with the same name are contiguous in the index, in document order
+	if(k == 0 && !s.any_name && n.parent()) {
+		if(auto* idx = n.parent()->index()) {
+			auto*    group    = idx->group(s.name, s.hash);
+			auto*    begin    = idx->named + group->begin;
+			auto*    end      = begin + group->count;
+			uint32_t position = idx->position(&n);
+			auto*    found    = std::lower_bound(begin, end, position, [](auto const& c, uint32_t p) { return c.position < p; });
+			return uint32_t(found - begin) + 1;
+		}
+	}
+
+	// Only has to count far enough to tell whether it's limit
+	uint32_t result = 1;
+	for(node* sibling = n.prev(); sibling && result <= limit; sibling = sibling->prev()) {
+		if(_test_at(s, *sibling, k)) result++;
+	}
+	return result;
+}
+
+bool query::_test_attribute(predicate const& p, node& n) const noexcept {
+	auto* idx = n.index();
+	attribute* a = idx ? idx->find_attribute(p.name, p.hash) : n.attrib(p.name);
+	if(!a) return false;
+	return p.kind != predicate::attribute_equals || a->value() == p.value;
+}
+
+} // namespace stx::xml
@@ -0,0 +1,121 @@
+// Copyright (c) 2017 Benno Straub, licensed under the MIT license. (A copy can be found at the end of this file)
+
+#pragma once
+
+#include "xml.hpp"
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace stx::xml {
+
+/// A path expression compiled once and evaluated over any number of nodes:
+///
+///   static const stx::xml::query titles("/feed/entry[@type='article'][2]/title");
+///   titles.each(doc, [](stx::xml::node& title) { ... });
+///
+/// Supports a subset of XPath which only selects elements:
+///   name, *          Child elements with that name, or all of them
+///   a/b              b children of a
+///   a//b             b descendants of a, //b at the start searches the whole document
+///   /a               Starts at the document (The topmost parent) instead of the given node
+///   .                The node itself, e.g. .//b
+///   [2]              Position among the matching children of the same parent, starting at 1
+///   [@x], [@x='v']   Has the attribute x, with the value v ("v" works too)
+/// Predicates apply in order, so a[@x][2] is the second a with an x attribute.
+/// Evaluation doesn't allocate, child steps use the node's index if document::enable_index() made one.
+/// From the first descendant step on, everything below the nodes matched so far is visited once.
+class query {
+public:
+	/// Throws parsing::errors::parsing_error if expression isn't part of the supported subset
+	explicit query(std::string_view expression);
+
+	/// Calls callback(node&) for every match in document order. If callback returns bool, false stops the search.
+	template<class Callback>
+	void each(node& context, Callback&& callback) const;
+
+	node*  first(node& context) const; //<! nullptr if nothing matches
+	size_t count(node& context) const;
+
+	std::string const& expression() const noexcept { return m_expression; }
+
+	static constexpr size_t max_predicates = 8; //<! Per step
+
+private:
+	struct predicate {
+		enum kind_t { position, has_attribute, attribute_equals };
+
+		kind_t      kind;
+		uint32_t    index = 0;  //<! position: 1 based
+		std::string name;
+		size_t      hash  = 0;
+		std::string value;
+	};
+
+	struct step {
+		enum kind_t { self, child, descendant };
+
+		kind_t                 kind;
+		bool                   any_name = false;
+		std::string            name;
+		size_t                 hash     = 0;
+		std::vector<predicate> predicates;
+	};
+
+	using match_fn = bool (*)(void* context, node& n);
+
+	bool _each(node& context, match_fn fn, void* fn_context) const;
+	/// Steps up to the first descendant step: Visits the matching children of n in order, every node has only one parent
+	bool _prefix(size_t i, node& n, match_fn fn, void* fn_context) const;
+	/// Steps from the descendant step first on: Visits everything below parent once in document order and matches it against the steps from the last one up to first
+	bool _descendants(size_t first, node& anchor, node& parent, match_fn fn, void* fn_context) const;
+	/// Whether n matches step i and its ancestors below anchor match the steps from first to i - 1
+	bool _match_up(size_t first, size_t i, node& n, node& anchor) const noexcept;
+
+	/// Tests the next candidate among the children of one parent, in order
+	bool     _test(step const& s, node& n, uint32_t* counters, bool& exhausted) const noexcept;
+	/// Tests n on its own, using the first num_predicates predicates. Positions are counted among the previous siblings.
+	bool     _test_at(step const& s, node& n, size_t num_predicates) const noexcept;
+	uint32_t _position(step const& s, node& n, size_t k) const noexcept; //<! Of n for predicate k, or something greater than its index
+	bool     _test_attribute(predicate const& p, node& n) const noexcept;
+
+	std::string       m_expression;
+	bool              m_absolute = false;
+	std::vector<step> m_steps;
+};
+
+// =============================================================
+// == Inline implementation =============================================
+// =============================================================
+
+template<class Callback>
+void query::each(node& context, Callback&& callback) const {
+	using callback_t = std::remove_reference_t<Callback>;
+	_each(context,
+		[](void* fn_context, node& n) -> bool {
+			auto& cb = *static_cast<callback_t*>(fn_context);
+			if constexpr(std::is_same_v<decltype(cb(n)), bool>) {
+				return cb(n);
+			}
+			else {
+				cb(n);
+				return true;
+			}
+		},
+		const_cast<void*>(static_cast<void const*>(&callback))
+	);
+}
+
+} // namespace stx::xml
+
+/*
+ Copyright (c) 2017 Benno Straub
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
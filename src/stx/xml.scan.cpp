@@ -0,0 +1,472 @@
+#include "xml.scan.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+	#define STX_XML_SCAN_SSE2 1
+	#include <emmintrin.h>
+	#if defined(__GNUC__) // Needs per function target attributes
+		#define STX_XML_SCAN_AVX2 1
+		#include <immintrin.h>
+	#endif
+#endif
+
+namespace stx::xml::detail {
+
+namespace {
+
+enum class scan_kind {
+	whitespace, //<! Stop at anything but whitespace
+	name,       //<! Stop at anything but name characters
+	chars       //<! Stop at one of two characters
+};
+
+// =============================================================
+// == Scalar =============================================
+// =============================================================
+
+bool _is_name_character(char c) noexcept {
+	return c > ' ' && c != 127 && c != '>' && c != '/' && c != '=';
+}
+
+template<scan_kind kind>
+const char* _scan_scalar(const char* s, char a, char b) noexcept {
+	if constexpr(kind == scan_kind::whitespace) {
+		while(*s != '\0' && *s <= ' ') s++;
+	}
+	else if constexpr(kind == scan_kind::name) {
+		while(_is_name_character(*s)) s++;
+	}
+	else {
+		while(*s != '\0' && *s != a && *s != b) s++;
+	}
+	return s;
+}
+
+bool _needs_escape(char c) noexcept {
+	return c == '<' || c == '>' || c == '&' || c == '"';
+}
+
+const char* _escape_scalar(const char* s, const char* end) noexcept {
+	while(s < end && !_needs_escape(*s)) s++;
+	return s;
+}
+
+// =============================================================
+// == SSE2 =============================================
+// =============================================================
+
+#ifdef STX_XML_SCAN_SSE2
+
+int _first_bit(unsigned mask) noexcept {
+#ifdef __GNUC__
+	return __builtin_ctz(mask);
+#else
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return int(index);
+#endif
+}
+
+template<scan_kind kind>
+unsigned _stop_mask_sse2(__m128i v, char a, char b) noexcept {
+	__m128i stop;
+	if constexpr(kind == scan_kind::whitespace) {
+		stop = _mm_or_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+	}
+	else if constexpr(kind == scan_kind::name) {
+		stop = _mm_or_si128(
+			_mm_or_si128(_mm_cmplt_epi8(v, _mm_set1_epi8(' ' + 1)), _mm_cmpeq_epi8(v, _mm_set1_epi8(127))),
+			_mm_or_si128(
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('>')),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), _mm_cmpeq_epi8(v, _mm_set1_epi8('=')))
+			)
+		);
+	}
+	else {
+		stop = _mm_or_si128(
+			_mm_cmpeq_epi8(v, _mm_setzero_si128()),
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(a)), _mm_cmpeq_epi8(v, _mm_set1_epi8(b)))
+		);
+	}
+	return unsigned(_mm_movemask_epi8(stop));
+}
+
+template<scan_kind kind>
+const char* _scan_sse2(const char* s, char a, char b) noexcept {
+	// Aligned loads can't cross into the next page, so reading past the terminator is safe
+	size_t      offset = uintptr_t(s) & 15;
+	const char* block  = s - offset;
+
+	unsigned mask = _stop_mask_sse2<kind>(_mm_load_si128((const __m128i*) block), a, b) & (~0u << offset);
+	while(!mask) {
+		block += 16;
+		mask = _stop_mask_sse2<kind>(_mm_load_si128((const __m128i*) block), a, b);
+	}
+	return block + _first_bit(mask);
+}
+
+unsigned _escape_mask_sse2(__m128i v) noexcept {
+	return unsigned(_mm_movemask_epi8(_mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('<')), _mm_cmpeq_epi8(v, _mm_set1_epi8('>'))),
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')), _mm_cmpeq_epi8(v, _mm_set1_epi8('"')))
+	)));
+}
+
+const char* _escape_sse2(const char* s, const char* end) noexcept {
+	// Unaligned loads, which stay within [s, end)
+	for(; end - s >= 16; s += 16) {
+		if(unsigned mask = _escape_mask_sse2(_mm_loadu_si128((const __m128i*) s))) {
+			return s + _first_bit(mask);
+		}
+	}
+	return _escape_scalar(s, end);
+}
+
+#endif // STX_XML_SCAN_SSE2
+
+// =============================================================
+// == AVX2 =============================================
+// =============================================================
+
+#ifdef STX_XML_SCAN_AVX2
+
+template<scan_kind kind> __attribute__((target("avx2")))
+unsigned _stop_mask_avx2(__m256i v, char a, char b) noexcept {
+	__m256i stop;
+	if constexpr(kind == scan_kind::whitespace) {
+		stop = _mm256_or_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+	}
+	else if constexpr(kind == scan_kind::name) {
+		stop = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(' ' + 1), v), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(127))),
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('=')))
+			)
+		);
+	}
+	else {
+		stop = _mm256_or_si256(
+			_mm256_cmpeq_epi8(v, _mm256_setzero_si256()),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(a)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(b)))
+		);
+	}
+	return unsigned(_mm256_movemask_epi8(stop));
+}
+
+template<scan_kind kind> __attribute__((target("avx2")))
+const char* _scan_avx2(const char* s, char a, char b) noexcept {
+	// Most tokens are short: Check the first 16 byte block before switching to 32 byte blocks
+	size_t      offset = uintptr_t(s) & 15;
+	const char* block  = s - offset;
+
+	unsigned mask = _stop_mask_sse2<kind>(_mm_load_si128((const __m128i*) block), a, b) & (~0u << offset);
+	if(mask) return block + __builtin_ctz(mask);
+	block += 16;
+
+	if(uintptr_t(block) & 31) {
+		mask = _stop_mask_sse2<kind>(_mm_load_si128((const __m128i*) block), a, b);
+		if(mask) return block + __builtin_ctz(mask);
+		block += 16;
+	}
+
+	while(!(mask = _stop_mask_avx2<kind>(_mm256_load_si256((const __m256i*) block), a, b))) {
+		block += 32;
+	}
+	return block + __builtin_ctz(mask);
+}
+
+__attribute__((target("avx2")))
+const char* _escape_avx2(const char* s, const char* end) noexcept {
+	for(; end - s >= 32; s += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) s);
+		__m256i stop = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('<')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('>'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')))
+		);
+		if(unsigned mask = unsigned(_mm256_movemask_epi8(stop))) {
+			return s + __builtin_ctz(mask);
+		}
+	}
+	return _escape_sse2(s, end);
+}
+
+#endif // STX_XML_SCAN_AVX2
+
+// =============================================================
+// == Dispatch =============================================
+// =============================================================
+
+using scan_fn   = const char* (*)(const char* s, char a, char b) noexcept;
+using escape_fn = const char* (*)(const char* s, const char* end) noexcept;
+
+struct scanners {
+	scan_isa  isa;
+	scan_fn   whitespace;
+	scan_fn   name;
+	scan_fn   chars;
+	escape_fn escape;
+};
+
+constexpr scanners _scalar = {
+	scan_isa::scalar,
+	_scan_scalar<scan_kind::whitespace>, _scan_scalar<scan_kind::name>, _scan_scalar<scan_kind::chars>,
+	_escape_scalar
+};
+#ifdef STX_XML_SCAN_SSE2
+constexpr scanners _sse2 = {
+	scan_isa::sse2,
+	_scan_sse2<scan_kind::whitespace>, _scan_sse2<scan_kind::name>, _scan_sse2<scan_kind::chars>,
+	_escape_sse2
+};
+#endif
+#ifdef STX_XML_SCAN_AVX2
+constexpr scanners _avx2 = {
+	scan_isa::avx2,
+	_scan_avx2<scan_kind::whitespace>, _scan_avx2<scan_kind::name>, _scan_avx2<scan_kind::chars>,
+	_escape_avx2
+};
+#endif
+
+bool _supported(scan_isa isa) noexcept {
+	switch(isa) {
+		case scan_isa::scalar: return true;
+#ifdef STX_XML_SCAN_SSE2
+		case scan_isa::sse2: return true;
+#endif
+#ifdef STX_XML_SCAN_AVX2
+		case scan_isa::avx2: return __builtin_cpu_supports("avx2");
+#endif
+		default: return false;
+	}
+}
+
+scanners const& _scanners_for(scan_isa isa) noexcept {
+	switch(isa) {
+#ifdef STX_XML_SCAN_AVX2
+		case scan_isa::avx2: return _avx2;
+#endif
+#ifdef STX_XML_SCAN_SSE2
+		case scan_isa::sse2: return _sse2;
+#endif
+		default: return _scalar;
+	}
+}
+
+// Selected on first use, so parsing during static initialization works
+std::atomic<scanners const*> _active{nullptr};
+
+scanners const& _get() noexcept {
+	scanners const* result = _active.load(std::memory_order_relaxed);
+	if(!result) {
+		result = &_scanners_for(best_scan_isa());
+		_active.store(result, std::memory_order_relaxed);
+	}
+	return *result;
+}
+
+} // namespace
+
+// =============================================================
+// == Interface =============================================
+// =============================================================
+
+const char* skip_whitespace(const char* s) noexcept           { return _get().whitespace(s, 0, 0); }
+const char* scan_name(const char* s) noexcept                 { return _get().name(s, 0, 0); }
+const char* find_char(const char* s, char c) noexcept         { return _get().chars(s, c, c); }
+const char* find_char(const char* s, char a, char b) noexcept { return _get().chars(s, a, b); }
+const char* find_escape(const char* s, const char* end) noexcept { return _get().escape(s, end); }
+
+scan_isa best_scan_isa() noexcept {
+	if(_supported(scan_isa::avx2)) return scan_isa::avx2;
+	if(_supported(scan_isa::sse2)) return scan_isa::sse2;
+	return scan_isa::scalar;
+}
+scan_isa active_scan_isa() noexcept {
+	return _get().isa;
+}
+bool use_scan_isa(scan_isa isa) noexcept {
+	if(!_supported(isa)) return false;
+	_active.store(&_scanners_for(isa), std::memory_order_relaxed);
+	return true;
+}
+
+// =============================================================
+// == Tokenizing =============================================
+// =============================================================
+
+void next_token(const char*& s) noexcept {
+	// TODO: conformance
+	s = skip_whitespace(s);
+}
+
+std::string_view parse_name(const char*& s) {
+	// TODO: conformance
+	const char* beg = s;
+	s = scan_name(s);
+
+	if(beg == s) {
+		throw errors::parsing_error("Expected valid name", s);
+	}
+
+	return {beg, size_t(s - beg)};
+}
+
+std::string_view parse_literal(const char*& s) {
+	if(*s == '\'') {
+		s++;
+		const char* start = s;
+		s = find_char(s, '\'');
+		if(!*s) {
+			throw errors::parsing_error(
+				"Expected closing single quote ' character",
+				s, { start, 1 }
+			);
+		}
+		auto result = std::string_view(start, size_t(s - start));
+		s++;
+		return result;
+	}
+	else if(*s == '"') {
+		s++;
+		const char* start = s;
+		s = find_char(s, '"');
+		if(!*s) {
+			throw errors::parsing_error(
+				"Expected closing double quote \" character",
+				s, { start, 1 }
+			);
+		}
+		auto result = std::string_view(start, size_t(s - start));
+		s++;
+		return result;
+	}
+	else {
+		throw errors::parsing_error("Expected literal (e.g. 'literal' or \"literal\")", s);
+	}
+}
+
+void parse_attribute(const char*& s, std::string_view& name, std::string_view& value) {
+	name = parse_name(s);
+	if(*s != '=') {
+		value = std::string_view();
+		return;
+	}
+	s++;
+	value = parse_literal(s);
+}
+
+const char* scan_content(const char* s) noexcept {
+	while(*(s = find_char(s, '<')) && s[1] <= ' ') s++; // '<' followed by whitespace doesn't start a tag
+	return s;
+}
+
+std::string_view trim_content(std::string_view s) noexcept {
+	while(!s.empty() && s.back() <= ' ') s.remove_suffix(1);
+	return s;
+}
+
+std::string_view trim_whitespace(std::string_view s) noexcept {
+	while(s.size() && std::isspace(s.front())) s.remove_prefix(1);
+	while(s.size() && std::isspace(s.back())) s.remove_suffix(1);
+	return s;
+}
+
+// =============================================================
+// == Decoding =============================================
+// =============================================================
+
+namespace {
+
+/// 0 for code points which aren't allowed in XML text: '\0', surrogates and anything above U+10FFFF
+size_t _encode_utf8(uint32_t c, char* out) noexcept {
+	if(c == 0 || (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) return 0;
+	if(c < 0x80) {
+		out[0] = char(c);
+		return 1;
+	}
+	if(c < 0x800) {
+		out[0] = char(0xC0 | (c >> 6));
+		out[1] = char(0x80 | (c & 0x3F));
+		return 2;
+	}
+	if(c < 0x10000) {
+		out[0] = char(0xE0 | (c >> 12));
+		out[1] = char(0x80 | ((c >> 6) & 0x3F));
+		out[2] = char(0x80 | (c & 0x3F));
+		return 3;
+	}
+	out[0] = char(0xF0 | (c >> 18));
+	out[1] = char(0x80 | ((c >> 12) & 0x3F));
+	out[2] = char(0x80 | ((c >> 6) & 0x3F));
+	out[3] = char(0x80 | (c & 0x3F));
+	return 4;
+}
+
+/// Writes the replacement of the reference starting at the '&' at s to out and advances s past it.
+/// Returns 0 for references which stay as they are. A reference is never shorter than its replacement (e.g. &#65536; is 4 bytes of UTF-8).
+size_t _decode_reference(const char*& s, const char* end, char* out) noexcept {
+	// Limits the search for ';' after stray ampersands, references with more leading zeros than that stay as they are
+	constexpr size_t max_reference_length = 32;
+
+	const char* semicolon = static_cast<const char*>(std::memchr(s, ';', std::min<size_t>(size_t(end - s), max_reference_length)));
+	if(!semicolon) return 0;
+
+	std::string_view reference(s + 1, size_t(semicolon - s - 1));
+	size_t length = 0;
+	if(reference.size() >= 2 && reference[0] == '#') {
+		bool        hex    = reference[1] == 'x';
+		const char* digits = reference.data() + (hex ? 2 : 1);
+		uint32_t    code_point;
+		std::from_chars_result result = std::from_chars(digits, semicolon, code_point, hex ? 16 : 10);
+		if(digits == semicolon || result.ec != std::errc() || result.ptr != semicolon) return 0;
+		length = _encode_utf8(code_point, out);
+	}
+	else if(reference == "amp")  { *out = '&';  length = 1; }
+	else if(reference == "lt")   { *out = '<';  length = 1; }
+	else if(reference == "gt")   { *out = '>';  length = 1; }
+	else if(reference == "quot") { *out = '"';  length = 1; }
+	else if(reference == "apos") { *out = '\''; length = 1; }
+
+	if(length) s = semicolon + 1;
+	return length;
+}
+
+} // namespace
+
+bool needs_decoding(std::string_view s, bool attribute) noexcept {
+	if(s.empty()) return false;
+	if(std::memchr(s.data(), '&', s.size()) || std::memchr(s.data(), '\r', s.size())) return true;
+	return attribute && (std::memchr(s.data(), '\n', s.size()) || std::memchr(s.data(), '\t', s.size()));
+}
+
+size_t decode(std::string_view s, bool attribute, char* out) noexcept {
+	const char* p   = s.data();
+	const char* end = p + s.size();
+	char*       o   = out;
+	while(p < end) {
+		char c = *p;
+		if(c == '&') {
+			if(size_t n = _decode_reference(p, end, o)) {
+				o += n;
+				continue;
+			}
+		}
+		else if(c == '\r') {
+			if(p + 1 < end && p[1] == '\n') p++; // \r\n is a single line break
+			c = '\n';
+		}
+		if(attribute && (c == '\n' || c == '\t')) c = ' ';
+		*o++ = c;
+		p++;
+	}
+	return size_t(o - out);
+}
+
+} // namespace stx::xml::detail
@@ -0,0 +1,74 @@
+// Internal: Character scanning and tokenizing shared by the XML parsers (node::parse_* and pull_parser)
+
+#pragma once
+
+#include "parsing.hpp"
+
+#include <string_view>
+
+namespace stx::xml::detail {
+
+namespace errors = ::stx::parsing::errors;
+
+// =============================================================
+// == Scanning =============================================
+// =============================================================
+
+// All scans stop at the terminating '\0' at the latest. Characters are compared as (signed) char, like the rest of the parser does,
+// so bytes >= 128 count as whitespace for skip_whitespace() and end names.
+// The vectorized versions read whole aligned blocks, which might extend past the terminator, but never past its page.
+
+/// First character which is neither '\0' nor whitespace (Anything <= ' ')
+const char* skip_whitespace(const char* s) noexcept;
+/// First character which can't be part of a name (Whitespace, control characters, '\0', DEL, '>', '/' and '=')
+const char* scan_name(const char* s) noexcept;
+/// First occurrence of c or '\0'
+const char* find_char(const char* s, char c) noexcept;
+/// First occurrence of a or b or '\0'
+const char* find_char(const char* s, char a, char b) noexcept;
+
+/// First of '<', '>', '&' or '"' in [s, end), or end. Doesn't need a terminator, only reads within the range.
+const char* find_escape(const char* s, const char* end) noexcept;
+
+enum class scan_isa {
+	scalar,
+	sse2,
+	avx2
+};
+
+/// The best instruction set supported by the CPU, which is used by default
+scan_isa best_scan_isa() noexcept;
+scan_isa active_scan_isa() noexcept;
+/// Switches all scans to isa, e.g. for comparing them. Returns false if the CPU doesn't support it. Not thread safe.
+bool use_scan_isa(scan_isa isa) noexcept;
+
+// =============================================================
+// == Tokenizing =============================================
+// =============================================================
+
+// All of these advance s past what they parsed, and throw errors::parsing_error on malformed input
+
+void             next_token(const char*& s) noexcept; //<! Skips whitespace
+std::string_view parse_name(const char*& s);
+std::string_view parse_literal(const char*& s);      //<! 'literal' or "literal", returns the part between the quotes
+void             parse_attribute(const char*& s, std::string_view& name, std::string_view& value); //<! name or name='value'
+
+/// End of content starting at s: The next '<' which starts markup (Isn't followed by whitespace), or '\0'
+const char*      scan_content(const char* s) noexcept;
+std::string_view trim_content(std::string_view s) noexcept;    //<! Removes trailing whitespace
+std::string_view trim_whitespace(std::string_view s) noexcept; //<! Removes leading and trailing whitespace
+
+// =============================================================
+// == Decoding =============================================
+// =============================================================
+
+// Entity references (&amp; &lt; &gt; &quot; &apos;) and character references (&#38; &#x26;) are replaced, others (e.g. &nbsp;,
+// since doctypes aren't parsed) and malformed ones stay as they are. Line breaks (\r\n and \r) become \n, and in attribute values
+// line breaks and tabs become spaces (XML 1.0 sections 2.11 and 3.3.3). The result is never longer than the raw text.
+
+/// Whether decode() would change s, i.e. it contains '&' or '\r' (or '\n' and '\t' in attribute values)
+bool   needs_decoding(std::string_view s, bool attribute) noexcept;
+/// Writes the decoded s to out, which has room for s.size() chars. Returns the decoded length.
+size_t decode(std::string_view s, bool attribute, char* out) noexcept;
+
+} // namespace stx::xml::detail
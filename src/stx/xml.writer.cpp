@@ -0,0 +1,215 @@
+#include "xml.writer.hpp"
+#include "xml.scan.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+
+#if __has_include(<unistd.h>)
+	#include <unistd.h>
+#endif
+
+namespace stx::xml {
+
+/// Whether the '&' at s starts an entity or character reference like &amp; &#38; or &#x26;
+static
+bool _is_reference(const char* s, const char* end) noexcept {
+	s++;
+	const char* begin;
+	if(s < end && *s == '#') {
+		s++;
+		bool hex = s < end && *s == 'x';
+		if(hex) s++;
+		begin = s;
+		while(s < end && (hex ? std::isxdigit((unsigned char) *s) : std::isdigit((unsigned char) *s))) s++;
+	}
+	else {
+		begin = s;
+		if(s < end && (std::isdigit((unsigned char) *s) || *s == '-' || *s == '.')) return false;
+		while(s < end && (std::isalnum((unsigned char) *s) || *s == '_' || *s == ':' || *s == '-' || *s == '.')) s++;
+	}
+	return s > begin && s < end && *s == ';';
+}
+
+writer::writer(write_options options) noexcept :
+	m_options(options)
+{}
+
+writer writer::to_fd(int fd, write_options options, size_t buffer_size) {
+	return writer(fd, options, buffer_size);
+}
+writer::writer(int fd, write_options options, size_t buffer_size) :
+	m_options(options),
+	m_fd(fd),
+	m_buffer(std::make_unique<char[]>(std::max<size_t>(buffer_size, 64))),
+	m_capacity(std::max<size_t>(buffer_size, 64))
+{
+#if !__has_include(<unistd.h>)
+	throw std::runtime_error("Writing xml to file descriptors isn't supported on this platform");
+#endif
+}
+
+writer::~writer() noexcept {
+	try {
+		flush();
+	}
+	catch(...) {}
+}
+
+void writer::flush() {
+#if __has_include(<unistd.h>)
+	if(m_fd < 0) return;
+
+	const char* s = m_buffer.get();
+	size_t      n = m_size;
+	m_size = 0;
+	while(n > 0) {
+		ssize_t written = ::write(m_fd, s, n);
+		if(written < 0) {
+			if(errno == EINTR) continue;
+			throw std::runtime_error("Failed writing xml output: " + std::string(std::strerror(errno)));
+		}
+		s += written;
+		n -= size_t(written);
+	}
+#endif
+}
+
+void writer::_reserve(size_t bytes) {
+	if(m_fd >= 0) {
+		flush();
+		if(m_capacity >= bytes) return;
+	}
+
+	size_t capacity = std::max({ m_capacity * 2, m_size + bytes, size_t(4096) });
+	auto   buffer   = std::make_unique<char[]>(capacity);
+	if(m_size) std::memcpy(buffer.get(), m_buffer.get(), m_size);
+	m_buffer   = std::move(buffer);
+	m_capacity = capacity;
+}
+
+writer& writer::write(node& n, unsigned depth) {
+	_node(n, depth);
+	return *this;
+}
+writer& writer::text(std::string_view s) {
+	_escaped(s, false, false);
+	return *this;
+}
+writer& writer::raw(std::string_view s) {
+	_put(s.data(), s.size());
+	return *this;
+}
+
+void writer::_indent(unsigned depth) {
+	if(!m_options.pretty) return;
+	size_t n = size_t(depth) * m_options.indent;
+	if(m_capacity - m_size < n) _reserve(n);
+	std::memset(m_buffer.get() + m_size, ' ', n);
+	m_size += n;
+}
+void writer::_line_end() {
+	if(m_options.pretty) _put('\n');
+}
+
+void writer::_escaped(std::string_view s, bool attribute, bool raw_xml) {
+	const char* p   = s.data();
+	const char* end = p + s.size();
+	while(true) {
+		const char* stop = detail::find_escape(p, end);
+		_put(p, size_t(stop - p));
+		if(stop == end) return;
+
+		switch(*stop) {
+			case '<': _put("&lt;", 4); break;
+			case '>':
+				if(attribute) _put('>');
+				else          _put("&gt;", 4);
+				break;
+			case '"':
+				if(attribute) _put("&quot;", 6);
+				else          _put('"');
+				break;
+			case '&':
+				if(raw_xml && _is_reference(stop, end)) _put('&');
+				else                                    _put("&amp;", 5);
+				break;
+		}
+		p = stop + 1;
+	}
+}
+
+void writer::_attributes(node& n) {
+	for(attribute* a = n.attributes(); a; a = a->next()) {
+		_put(' ');
+		_put(a->name().data(), a->name().size());
+		if(a->value().data()) { // Attributes without value (e.g. <input disabled>) stay that way
+			_put("=\"", 2);
+			_escaped(a->value(), true, true);
+			_put('"');
+		}
+	}
+}
+
+void writer::_node(node& n, unsigned depth) {
+	switch(n.type()) {
+		case node::unassigned: {
+			// A document
+			for(node* c = n.children(); c; c = c->next()) _node(*c, depth);
+		} return;
+		case node::doctype: return;
+		case node::regular: {
+			std::string_view name = n.name();
+			_indent(depth);
+			_put('<');
+			_put(name.data(), name.size());
+			_attributes(n);
+
+			node* c = n.children();
+			if(!c) {
+				_put("/>", 2);
+				break;
+			}
+			_put('>');
+			if(m_options.pretty && c->type() == node::content && !c->next()) {
+				_escaped(c->content_value(), false, true);
+			}
+			else {
+				_line_end();
+				for(; c; c = c->next()) _node(*c, depth + 1);
+				_indent(depth);
+			}
+			_put("</", 2);
+			_put(name.data(), name.size());
+			_put('>');
+		} break;
+		case node::content: {
+			_indent(depth);
+			_escaped(n.content_value(), false, true);
+		} break;
+		case node::comment: {
+			_indent(depth);
+			_put("<!--", 4);
+			raw(n.comment_value());
+			_put("-->", 3);
+		} break;
+		case node::processing_instruction: {
+			_indent(depth);
+			_put("<?", 2);
+			raw(n.processing_instruction_name());
+			_attributes(n);
+			_put("?>", 2);
+		} break;
+		case node::cdata: {
+			_indent(depth);
+			_put("<![CDATA[", 9);
+			raw(n.cdata_value());
+			_put("]]>", 3);
+		} break;
+	}
+	_line_end();
+}
+
+} // namespace stx::xml
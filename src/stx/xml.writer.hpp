@@ -0,0 +1,89 @@
+// Copyright (c) 2017 Benno Straub, licensed under the MIT license. (A copy can be found at the end of this file)
+
+#pragma once
+
+#include "xml.hpp"
+
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace stx::xml {
+
+struct write_options {
+	bool     pretty = false; //<! One node per line, indented by depth. Elements which only contain text stay on one line.
+	unsigned indent = 2;     //<! Spaces per level when pretty printing
+};
+
+/// Serializes nodes into a growable buffer, or through a buffer into a file descriptor:
+///
+///   stx::xml::writer out;
+///   out.write(doc);
+///   std::string_view xml = out.view();
+///
+/// Text and attribute values in the DOM are raw xml (Entities aren't decoded), so '&' is only escaped if it doesn't start
+/// an entity or character reference (e.g. &amp; or &#x20;). '<' and '>' in text, '<' and '"' in attribute values are always escaped.
+/// Doctypes aren't kept by the parser, so they are skipped.
+class writer {
+public:
+	static constexpr size_t default_buffer_size = 64 * 1024;
+
+	explicit writer(write_options options = {}) noexcept;
+	/// Writes to fd (POSIX only) whenever buffer_size bytes are buffered. The descriptor has to stay open until the writer is destroyed.
+	static writer to_fd(int fd, write_options options = {}, size_t buffer_size = default_buffer_size);
+	~writer() noexcept; //<! Flushes, but can't report errors, call flush() to see them
+
+	writer(writer const&) = delete;
+	writer& operator=(writer const&) = delete;
+
+	/// Writes n and everything below it, or the children of a document. depth is the indentation level to start at.
+	writer& write(node& n, unsigned depth = 0);
+
+	/// Escapes everything special, including every '&', e.g. for text which didn't come from a parsed document
+	writer& text(std::string_view s);
+	writer& raw(std::string_view s);
+
+	/// Everything written so far, which wasn't flushed to the file descriptor yet
+	std::string_view view() const noexcept { return { m_buffer.get(), m_size }; }
+	void clear() noexcept { m_size = 0; }
+
+	/// Writes the buffer to the file descriptor, throws std::runtime_error on failure. Does nothing without a file descriptor.
+	void flush();
+
+private:
+	writer(int fd, write_options options, size_t buffer_size);
+
+	void _node(node& n, unsigned depth);
+	void _escaped(std::string_view s, bool attribute, bool raw_xml);
+	void _indent(unsigned depth);
+	void _line_end();
+	void _attributes(node& n);
+	void _reserve(size_t bytes);
+	void _put(const char* s, size_t n) {
+		if(m_capacity - m_size < n) _reserve(n);
+		std::memcpy(m_buffer.get() + m_size, s, n);
+		m_size += n;
+	}
+	void _put(char c) {
+		if(m_size == m_capacity) _reserve(1);
+		m_buffer[m_size++] = c;
+	}
+
+	write_options           m_options;
+	int                     m_fd = -1;
+	std::unique_ptr<char[]> m_buffer;
+	size_t                  m_size     = 0;
+	size_t                  m_capacity = 0;
+};
+
+} // namespace stx::xml
+
+/*
+ Copyright (c) 2017 Benno Straub
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
@@ -0,0 +1,72 @@
+#include "../../unit/catch.hpp"
+
+#include <stx/async/threadpool.hpp>
+#include <stx/async/numa_threadpool.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Memory-bound work on pinned and unpinned workers.
+// Every task streams over its own buffer, which was first touched by a task with the same index,
+// so pinned workers (and NUMA sub-pools) keep their buffers in node-local memory and warm caches.
+
+constexpr size_t buffer_size = 4 << 20; // Per task, larger than most L2 caches
+
+template<class Executor>
+void bench_streaming(std::string const& name, Executor& pool, size_t num_tasks) {
+	std::vector<std::unique_ptr<uint64_t[]>> buffers(num_tasks);
+
+	auto run_all = [&](auto fn) {
+		std::atomic<size_t> remaining{num_tasks};
+		for(size_t i = 0; i < num_tasks; i++) {
+			pool.defer([&, i]() { fn(i); remaining--; });
+		}
+		while(remaining > 0) std::this_thread::yield();
+	};
+
+	// First touch on the workers
+	run_all([&](size_t i) {
+		buffers[i].reset(new uint64_t[buffer_size / sizeof(uint64_t)]);
+		for(size_t j = 0; j < buffer_size / sizeof(uint64_t); j++) buffers[i][j] = j;
+	});
+
+	BENCHMARK(std::string(name)) {
+		std::atomic<uint64_t> total{0};
+		run_all([&](size_t i) {
+			uint64_t sum = 0;
+			for(size_t j = 0; j < buffer_size / sizeof(uint64_t); j++) sum += buffers[i][j];
+			total += sum;
+		});
+		return total.load();
+	};
+}
+
+TEST_CASE("Thread affinity: pinned vs. unpinned", "[affinity][benchmark]") {
+	auto   nodes   = stx::numa_nodes();
+	size_t threads = 0;
+	for(auto& node : nodes) threads += node.size();
+
+	stx::cpu_set all;
+	for(auto& node : nodes) all.insert(all.end(), node.begin(), node.end());
+
+	{
+		stx::threadpool pool{int(threads)};
+		bench_streaming("unpinned threadpool, " + std::to_string(threads) + " threads", pool, threads);
+	}
+	{
+		stx::thread_options options;
+		options.name         = "pinned";
+		options.cpus         = all;
+		options.one_cpu_each = true;
+		stx::threadpool pool(int(threads), options);
+		bench_streaming("pinned threadpool, " + std::to_string(threads) + " threads", pool, threads);
+	}
+	{
+		stx::numa_threadpool pool;
+		bench_streaming("numa_threadpool, " + std::to_string(nodes.size()) + " nodes", pool.node(0), nodes[0].size());
+	}
+}
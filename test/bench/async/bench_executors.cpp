@@ -0,0 +1,102 @@
+#include "../../unit/catch.hpp"
+
+#include <stx/async/threadpool.hpp>
+#include <stx/async/work_stealing_pool.hpp>
+#include <stx/async/task_ring.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput of tiny tasks depending on the number of worker threads
+
+static
+std::vector<int> thread_counts() {
+	std::vector<int> result;
+	int max = std::max(4, int(std::thread::hardware_concurrency()));
+	for(int n = 1; n <= max; n *= 2) result.push_back(n);
+	return result;
+}
+
+static
+void wait_for(std::atomic<int>& remaining) {
+	while(remaining > 0) std::this_thread::yield();
+}
+
+template<class Executor>
+void bench_external_producer(const char* name) {
+	constexpr int num_tasks = 100000;
+
+	for(int threads : thread_counts()) {
+		Executor pool(threads);
+
+		BENCHMARK(std::string(name) + " external producer, " + std::to_string(threads) + " threads") {
+			std::atomic<int> remaining{num_tasks};
+			for(int i = 0; i < num_tasks; i++) {
+				pool.defer([&]() { remaining--; });
+			}
+			wait_for(remaining);
+			return remaining.load();
+		};
+	}
+}
+
+template<class Executor>
+void bench_fan_out(const char* name) {
+	constexpr int num_parents  = 1000;
+	constexpr int num_children = 100;
+
+	for(int threads : thread_counts()) {
+		Executor pool(threads);
+
+		BENCHMARK(std::string(name) + " fan out, " + std::to_string(threads) + " threads") {
+			std::atomic<int> remaining{num_parents * num_children};
+			for(int i = 0; i < num_parents; i++) {
+				pool.defer([&]() {
+					for(int j = 0; j < num_children; j++) {
+						pool.defer([&]() { remaining--; });
+					}
+				});
+			}
+			wait_for(remaining);
+			return remaining.load();
+		};
+	}
+}
+
+TEST_CASE("Executor throughput: threadpool", "[threadpool][benchmark]") {
+	bench_external_producer<stx::threadpool>("threadpool");
+	bench_fan_out<stx::threadpool>("threadpool");
+}
+
+TEST_CASE("Executor throughput: work_stealing_pool", "[work_stealing_pool][benchmark]") {
+	bench_external_producer<stx::work_stealing_pool>("work_stealing_pool");
+	bench_fan_out<stx::work_stealing_pool>("work_stealing_pool");
+}
+
+TEST_CASE("Executor throughput: task_ring", "[task_ring][benchmark]") {
+	constexpr int num_tasks = 100000;
+
+	for(int threads : thread_counts()) {
+		for(auto policy : { stx::task_ring::block, stx::task_ring::spin }) {
+			stx::task_ring ring(1024, policy);
+			std::vector<std::thread> consumers;
+			for(int i = 0; i < threads; i++) {
+				consumers.emplace_back([&]() { ring.start(); });
+			}
+
+			BENCHMARK(std::string("task_ring external producer, ") + (policy == stx::task_ring::block ? "block" : "spin") + ", " + std::to_string(threads) + " threads") {
+				std::atomic<int> remaining{num_tasks};
+				for(int i = 0; i < num_tasks; i++) {
+					ring.defer([&]() { remaining--; });
+				}
+				wait_for(remaining);
+				return remaining.load();
+			};
+
+			ring.stop();
+			for(auto& t : consumers) t.join();
+		}
+	}
+}
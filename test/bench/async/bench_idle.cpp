@@ -0,0 +1,66 @@
+#include "../../unit/catch.hpp"
+
+#include <stx/async/threadpool.hpp>
+#include <stx/async/work_stealing_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+// Idle CPU usage, wake-up latency and shutdown latency of thread pools
+
+template<class Pool>
+void report_idle_behaviour(const char* name, int threads) {
+	constexpr auto idle_duration = 250ms;
+	constexpr int  wakeups       = 50;
+
+	auto* pool = new Pool(threads);
+	std::this_thread::sleep_for(20ms); // Let the threads settle
+
+	// CPU time burned while nothing is deferred
+	std::clock_t cpu_start = std::clock();
+	std::this_thread::sleep_for(idle_duration);
+	double idle_cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+	// Time from defer() on an idle pool until the task starts running
+	duration<double, std::micro> wakeup_latency{0};
+	for(int i = 0; i < wakeups; i++) {
+		std::this_thread::sleep_for(2ms);
+		std::atomic<bool> done{false};
+		steady_clock::time_point started;
+		auto deferred = steady_clock::now();
+		pool->defer([&]() { started = steady_clock::now(); done = true; });
+		while(!done) std::this_thread::yield();
+		wakeup_latency += started - deferred;
+	}
+
+	// Time to stop an idle pool
+	auto stop_start = steady_clock::now();
+	delete pool;
+	duration<double, std::micro> shutdown_latency = steady_clock::now() - stop_start;
+
+	std::printf(
+		"%-18s %3i threads: idle cpu %5.1f%% of one core, wake-up latency %8.1fus, shutdown %8.1fus\n",
+		name, threads,
+		100.0 * idle_cpu / duration<double>(idle_duration).count(),
+		wakeup_latency.count() / wakeups,
+		shutdown_latency.count()
+	);
+}
+
+TEST_CASE("Idle behaviour: threadpool", "[threadpool][benchmark]") {
+	for(int threads : { 1, 8, 64 }) {
+		report_idle_behaviour<stx::threadpool>("threadpool", threads);
+	}
+}
+
+TEST_CASE("Idle behaviour: work_stealing_pool", "[work_stealing_pool][benchmark]") {
+	for(int threads : { 1, 8, 64 }) {
+		report_idle_behaviour<stx::work_stealing_pool>("work_stealing_pool", threads);
+	}
+}
@@ -0,0 +1,37 @@
+#include "../../unit/catch.hpp"
+
+#include <stx/async/instrumented_executor.hpp>
+#include <stx/async/task_queue.hpp>
+
+#include <cstdio>
+
+// Overhead of recording stats per task
+
+TEST_CASE("Instrumentation overhead", "[instrumented_executor][benchmark]") {
+	constexpr int num_tasks = 10000;
+
+	stx::task_queue            queue;
+	stx::instrumented_executor instrumented(queue);
+
+	BENCHMARK("task_queue, plain") {
+		int n = 0;
+		for(int i = 0; i < num_tasks; i++) queue.defer([&]() { n++; });
+		queue.execute_tasks();
+		return n;
+	};
+
+	BENCHMARK("task_queue, instrumented") {
+		int n = 0;
+		for(int i = 0; i < num_tasks; i++) instrumented.defer([&]() { n++; });
+		queue.execute_tasks();
+		return n;
+	};
+
+	auto stats = instrumented.stats();
+	std::printf(
+		"instrumented: %llu tasks, max queue depth %llu, wait p50 %lldns p99 %lldns, run p50 %lldns p99 %lldns\n",
+		(unsigned long long) stats.finished, (unsigned long long) stats.max_queue_depth,
+		(long long) stats.wait_time.percentile(0.5).count(), (long long) stats.wait_time.percentile(0.99).count(),
+		(long long) stats.run_time.percentile(0.5).count(),  (long long) stats.run_time.percentile(0.99).count()
+	);
+}
@@ -0,0 +1,44 @@
+#include "../../unit/catch.hpp"
+
+#include <stx/async/parallel.hpp>
+#include <stx/async/threadpool.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+// One deferred task per element versus parallel_for's chunking
+
+TEST_CASE("Parallel loops: defer per element vs. parallel_for", "[parallel][benchmark]") {
+	constexpr size_t num_elements = 1 << 20;
+
+	stx::threadpool    pool(std::max(1, int(std::thread::hardware_concurrency()) - 1));
+	std::vector<float> data(num_elements, 1.f);
+
+	BENCHMARK("defer per element") {
+		std::atomic<size_t> remaining{num_elements};
+		for(size_t i = 0; i < num_elements; i++) {
+			pool.defer([&, i]() { data[i] = std::sqrt(data[i] + 1.f); remaining--; });
+		}
+		while(remaining > 0) std::this_thread::yield();
+		return data[0];
+	};
+
+	BENCHMARK("parallel_for, automatic grain") {
+		stx::parallel_for(pool, 0, num_elements, 0, [&](size_t i) { data[i] = std::sqrt(data[i] + 1.f); });
+		return data[0];
+	};
+
+	BENCHMARK("parallel_reduce, automatic grain") {
+		return stx::parallel_reduce(pool, 0, num_elements, 0, 0.f,
+			[&](float acc, size_t i) { return acc + data[i]; },
+			[](float a, float b) { return a + b; }
+		);
+	};
+
+	BENCHMARK("serial loop") {
+		for(size_t i = 0; i < num_elements; i++) data[i] = std::sqrt(data[i] + 1.f);
+		return data[0];
+	};
+}
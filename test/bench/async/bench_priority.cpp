@@ -0,0 +1,57 @@
+#include "../../unit/catch.hpp"
+
+#include <stx/async/task_queue.hpp>
+#include <stx/async/priority_task_queue.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using namespace std::chrono;
+
+// Cost of priority scheduling, and how long an urgent task waits behind bulk work
+
+template<class Queue>
+void bench_mixed_priorities(const char* name) {
+	constexpr int num_tasks = 100000;
+
+	Queue queue;
+	BENCHMARK(std::string(name) + " defer & execute, mixed priorities") {
+		int n = 0;
+		for(int i = 0; i < num_tasks; i++) {
+			queue.defer([&]() { n++; }, float(i % 8 - 4));
+		}
+		queue.execute_tasks();
+		return n;
+	};
+}
+
+TEST_CASE("Priority scheduling: task_queue", "[task_queue][benchmark]") {
+	bench_mixed_priorities<stx::task_queue>("task_queue");
+}
+
+TEST_CASE("Priority scheduling: priority_task_queue", "[priority_task_queue][benchmark]") {
+	bench_mixed_priorities<stx::priority_task_queue>("priority_task_queue");
+
+	// An urgent task deferred from the first of 1000 bulk tasks, each taking ~10us
+	for(auto mode : { stx::priority_task_queue::strict, stx::priority_task_queue::deadline }) {
+		stx::priority_task_queue queue(mode);
+		steady_clock::time_point deferred, started;
+		queue.defer([&]() {
+			deferred = steady_clock::now();
+			queue.defer([&]() { started = steady_clock::now(); }, -4);
+		}, 4);
+		for(int i = 0; i < 1000; i++) {
+			queue.defer([]() {
+				auto end = steady_clock::now() + 10us;
+				while(steady_clock::now() < end);
+			}, 4);
+		}
+		queue.execute_tasks();
+		std::printf(
+			"priority_task_queue (%s): urgent task waited %.1fus behind bulk work\n",
+			mode == stx::priority_task_queue::strict ? "strict" : "deadline",
+			duration<double, std::micro>(started - deferred).count()
+		);
+	}
+}
@@ -0,0 +1,23 @@
+#include "../../unit/catch.hpp"
+
+#include <stx/async/task_queue.hpp>
+
+// Allocations per task are counted by the bench_allocations executable
+
+template<size_t CaptureSize>
+struct capture {
+	char data[CaptureSize];
+	void operator()() const noexcept {}
+};
+
+TEST_CASE("Deferring tasks with inline captures", "[task][benchmark]") {
+	stx::task_queue queue;
+	BENCHMARK("task_queue::defer + execute_tasks, 8 byte capture") {
+		for(int i = 0; i < 1000; i++) queue.defer(capture<8>());
+		return queue.execute_tasks();
+	};
+	BENCHMARK("task_queue::defer + execute_tasks, 64 byte capture") {
+		for(int i = 0; i < 1000; i++) queue.defer(capture<64>());
+		return queue.execute_tasks();
+	};
+}
@@ -0,0 +1,118 @@
+#include "../unit/catch.hpp"
+
+#include <stx/allocator.hpp>
+
+#include <cstdlib>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// The request pattern: Allocate many small objects, then free them all at once
+
+constexpr int num_allocations = 10000;
+
+static
+size_t allocation_size(int i) noexcept {
+	return 16 + (size_t(i) * 7919) % 112; // 16 to 127 bytes
+}
+
+TEST_CASE("Allocate many, free all: malloc vs. arena", "[allocator][benchmark]") {
+	std::vector<void*> pointers(num_allocations);
+
+	BENCHMARK("malloc/free") {
+		for(int i = 0; i < num_allocations; i++) {
+			pointers[i] = std::malloc(allocation_size(i));
+			*(char*) pointers[i] = char(i);
+		}
+		for(void* p : pointers) std::free(p);
+		return pointers[0];
+	};
+
+	BENCHMARK("arena_allocator, new arena per request") {
+		stx::arena_allocator arena;
+		char* p = nullptr;
+		for(int i = 0; i < num_allocations; i++) {
+			p = arena.alloc(allocation_size(i));
+			*p = char(i);
+		}
+		return p;
+	};
+
+	stx::arena_allocator arena;
+	BENCHMARK("arena_allocator, reset() with retained blocks") {
+		char* p = nullptr;
+		for(int i = 0; i < num_allocations; i++) {
+			p = arena.alloc(allocation_size(i));
+			*p = char(i);
+		}
+		arena.reset();
+		return p;
+	};
+
+	BENCHMARK("thread_arena() with arena_scope") {
+		stx::arena_scope scope(stx::thread_arena());
+		char* p = nullptr;
+		for(int i = 0; i < num_allocations; i++) {
+			p = stx::thread_arena().alloc(allocation_size(i));
+			*p = char(i);
+		}
+		return p;
+	};
+}
+
+// Request scoped containers: Build a small map of strings, then throw it away
+TEST_CASE("Request scoped containers: std vs. arena", "[allocator][benchmark]") {
+	constexpr int num_entries = 1000;
+
+	BENCHMARK("std::map<std::string, std::string>") {
+		std::map<std::string, std::string> m;
+		for(int i = 0; i < num_entries; i++) {
+			m.emplace(std::to_string(i) + " is a key too long for SSO", "and a value which is too long as well");
+		}
+		return m.size();
+	};
+
+	stx::arena_allocator arena;
+	BENCHMARK("std::pmr::map<std::pmr::string, std::pmr::string> on arena_memory_resource") {
+		stx::arena_scope           scope(arena);
+		stx::arena_memory_resource resource(arena);
+		std::pmr::map<std::pmr::string, std::pmr::string> m(&resource);
+		for(int i = 0; i < num_entries; i++) {
+			m.emplace(std::to_string(i) + " is a key too long for SSO", "and a value which is too long as well");
+		}
+		return m.size();
+	};
+}
+
+// Per frame scratch data, e.g. rasterizer spans, living for one frame after the one they were made in
+TEST_CASE("Per frame scratch data: malloc vs. ring_allocator", "[allocator][benchmark]") {
+	constexpr int frames_in_flight = 2;
+	std::vector<void*> frames[frames_in_flight];
+	int frame = 0;
+
+	BENCHMARK("malloc/free") {
+		auto& retired = frames[frame++ % frames_in_flight];
+		for(void* p : retired) std::free(p);
+		retired.clear();
+
+		for(int i = 0; i < num_allocations; i++) {
+			retired.push_back(std::malloc(allocation_size(i)));
+			*(char*) retired.back() = char(i);
+		}
+		return retired.size();
+	};
+	for(auto& f : frames) for(void* p : f) std::free(p);
+
+	stx::ring_allocator ring(4 << 20, frames_in_flight);
+	BENCHMARK("ring_allocator") {
+		ring.next_frame();
+		char* p = nullptr;
+		for(int i = 0; i < num_allocations; i++) {
+			p = ring.alloc(allocation_size(i));
+			*p = char(i);
+		}
+		return p;
+	};
+	CHECK_FALSE(ring.overflowed());
+}
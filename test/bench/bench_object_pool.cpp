@@ -0,0 +1,68 @@
+#include "../unit/catch.hpp"
+
+#include <stx/object_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Multithreaded churn: Every thread keeps a window of live objects, replacing them in a round robin.
+// Half of the threads hand their objects to a neighbour, which frees them (The cross thread path).
+
+namespace {
+
+struct connection_state {
+	char data[72];
+};
+
+constexpr int num_operations = 100000;
+constexpr int window_size    = 256;
+
+template<class Alloc, class Free>
+void churn(int num_threads, Alloc alloc, Free free) {
+	std::vector<std::atomic<connection_state*>> handoff(num_threads);
+	std::vector<std::thread> threads;
+
+	for(int t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			std::vector<connection_state*> window(window_size, nullptr);
+			for(int i = 0; i < num_operations; i++) {
+				connection_state*& slot = window[i % window_size];
+				if(slot) free(slot);
+				slot = alloc();
+				slot->data[0] = char(i);
+
+				// Pass every 8th object on to the next thread
+				if(t % 2 == 0 && i % 8 == 0) {
+					if(connection_state* old = handoff[(t + 1) % num_threads].exchange(slot)) free(old);
+					slot = nullptr;
+				}
+				if(t % 2 == 1) {
+					if(connection_state* received = handoff[t].exchange(nullptr)) free(received);
+				}
+			}
+			for(connection_state* p : window) if(p) free(p);
+		});
+	}
+	for(auto& thread : threads) thread.join();
+	for(auto& slot : handoff) if(connection_state* p = slot.exchange(nullptr)) free(p);
+}
+
+} // namespace
+
+TEST_CASE("Multithreaded churn: new/delete vs. object pools", "[object_pool][benchmark]") {
+	int num_threads = std::max(2, int(std::thread::hardware_concurrency()));
+
+	BENCHMARK("new/delete") {
+		churn(num_threads,
+			[]() { return new connection_state; },
+			[](connection_state* p) { delete p; });
+	};
+
+	BENCHMARK("pool_new/pool_delete") {
+		churn(num_threads,
+			[]() { return stx::pool_new<connection_state>(); },
+			[](connection_state* p) { stx::pool_delete(p); });
+	};
+}
@@ -0,0 +1,288 @@
+#include "../unit/catch.hpp"
+
+#include <stx/xml.hpp>
+#include <stx/async/threadpool.hpp>
+#include <stx/xml.pull.hpp>
+#include <stx/xml.query.hpp>
+#include <stx/xml.scan.hpp>
+#include <stx/xml.writer.hpp>
+#include <stx/file2vector.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <sstream>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A feed-like corpus: Many records with attributes, nested elements, text content and comments
+
+static
+std::string make_corpus(size_t min_bytes) {
+	std::string result = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<feed>\n";
+	for(int i = 0; result.size() < min_bytes; i++) {
+		std::string id = std::to_string(i);
+		result +=
+			"  <entry id=\"" + id + "\" type='article' language=\"en\">\n"
+			"    <title>Entry number " + id + " of the benchmark corpus</title>\n"
+			"    <author name=\"Some Author\" email='author@example.com'/>\n"
+			"    <!-- A comment which the parser has to skip over -->\n"
+			"    <summary>\n"
+			"      Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor\n"
+			"      incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud.\n"
+			"    </summary>\n"
+			"    <link href=\"https://example.com/entries/" + id + "\" rel='alternate'/>\n"
+			"  </entry>\n";
+	}
+	result += "</feed>\n";
+	return result;
+}
+
+static
+const char* isa_name(stx::xml::detail::scan_isa isa) {
+	switch(isa) {
+		case stx::xml::detail::scan_isa::scalar: return "scalar";
+		case stx::xml::detail::scan_isa::sse2:   return "sse2";
+		case stx::xml::detail::scan_isa::avx2:   return "avx2";
+	}
+	return "?";
+}
+
+TEST_CASE("XML parsing throughput per scanner", "[xml][benchmark]") {
+	using namespace stx::xml::detail;
+
+	std::string corpus = make_corpus(16 << 20);
+	scan_isa    best   = best_scan_isa();
+
+	for(auto isa : { scan_isa::scalar, scan_isa::sse2, scan_isa::avx2 }) {
+		if(!use_scan_isa(isa)) continue;
+
+		BENCHMARK(std::string("document::parse, ") + isa_name(isa)) {
+			return stx::xml::document::parse(corpus.c_str()).children() != nullptr;
+		};
+
+		// Catch doesn't report throughput, so measure MB/s separately
+		auto start = std::chrono::steady_clock::now();
+		constexpr int runs = 5;
+		for(int i = 0; i < runs; i++) {
+			stx::xml::document::parse(corpus.c_str());
+		}
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+		std::printf("document::parse, %s: %.1f MB/s\n", isa_name(isa), runs * corpus.size() / seconds.count() / 1e6);
+	}
+
+	use_scan_isa(best);
+}
+
+TEST_CASE("Loading XML files: read vs. mmap", "[xml][benchmark]") {
+	std::string corpus = make_corpus(64 << 20);
+	const char* path   = "/tmp/stx_bench_xml_load.xml";
+
+	FILE* file = std::fopen(path, "wb");
+	REQUIRE(file);
+	std::fwrite(corpus.data(), 1, corpus.size(), file);
+	std::fclose(file);
+	corpus = std::string(); // Don't count it towards memory usage
+
+	// What load() used to do, the string has to outlive the document
+	BENCHMARK("file2string, then parse") {
+		std::string text = stx::file2string(path);
+		return stx::xml::document::parse(text.c_str()).children() != nullptr;
+	};
+	BENCHMARK("document::load, read") {
+		return stx::xml::document::load(path, false).children() != nullptr;
+	};
+	BENCHMARK("document::load, mapped") {
+		return stx::xml::document::load(path).children() != nullptr;
+	};
+
+	// Only needs a buffer as big as the biggest tag or text, instead of the whole file and its DOM
+	size_t capacity = 0;
+	BENCHMARK("pull_parser, read") {
+		int fd = ::open(path, O_RDONLY);
+		stx::xml::pull_parser parser(stx::xml::pull_parser::read_fd(fd));
+		size_t entries = 0;
+		while(parser.next() != stx::xml::pull_parser::end_of_document) {
+			if(parser.type() == stx::xml::pull_parser::start_element && parser.name() == "entry") entries++;
+		}
+		::close(fd);
+		capacity = parser.buffer_capacity();
+		return entries;
+	};
+	std::printf("pull_parser buffer: %zu bytes\n", capacity);
+
+	std::remove(path);
+}
+
+TEST_CASE("Parallel XML parsing scaling", "[xml][benchmark]") {
+	std::string corpus = make_corpus(128 << 20);
+
+	// parallel_for() never uses more threads than the hardware has, so results flatten out there
+	std::printf("Hardware threads: %u\n", std::thread::hardware_concurrency());
+
+	for(int threads : { 1, 2, 4, 8, 16, 32 }) {
+		stx::threadpool pool(std::max(1, threads - 1)); // The calling thread parses chunks too
+
+		auto start = std::chrono::steady_clock::now();
+		constexpr int runs = 3;
+		for(int i = 0; i < runs; i++) {
+			stx::xml::document::parse(corpus.c_str(), pool, size_t(threads));
+		}
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+		std::printf("document::parse, %2d threads: %.1f MB/s\n", threads, runs * corpus.size() / seconds.count() / 1e6);
+	}
+}
+
+TEST_CASE("XML lookups by name: walking vs. index", "[xml][benchmark]") {
+	// Looks up every child of a node with n children once, so walking costs n / 2 comparisons on average
+	std::printf("%8s %14s %14s\n", "children", "walk ns/child", "index ns/child");
+	for(size_t n : { 2, 4, 8, 16, 32, 64, 128, 1024, 8192 }) {
+		std::string text = "<root>";
+		std::vector<std::string> names;
+		for(size_t i = 0; i < n; i++) {
+			names.push_back("child_element_" + std::to_string(i));
+			text += "<" + names.back() + " value='" + std::to_string(i) + "'/>";
+		}
+		text += "</root>";
+
+		double ns[2];
+		for(bool indexed : { false, true }) {
+			stx::xml::document doc = stx::xml::document::parse(text.c_str());
+			if(indexed) doc.enable_index(1);
+			stx::xml::node& root = doc.req_child("root");
+
+			size_t found  = 0;
+			size_t rounds = std::max<size_t>(1, (1 << 22) / (n * (indexed ? 1 : n)));
+			auto start = std::chrono::steady_clock::now();
+			for(size_t r = 0; r < rounds; r++) {
+				for(auto& name : names) {
+					found += root.child(name) != nullptr;
+				}
+			}
+			std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+			REQUIRE(found == rounds * n);
+			ns[indexed] = elapsed.count() / (rounds * n);
+		}
+		std::printf("%8zu %14.1f %14.1f\n", n, ns[0], ns[1]);
+	}
+}
+
+TEST_CASE("XML queries vs. hand written lookups", "[xml][benchmark]") {
+	std::string corpus = make_corpus(4 << 20);
+	stx::xml::document doc     = stx::xml::document::parse(corpus.c_str());
+	stx::xml::document indexed = stx::xml::document::parse(corpus.c_str());
+	indexed.enable_index();
+
+	const stx::xml::query titles("/feed/entry[@type='article']/title");
+	const stx::xml::query nth("/feed/entry[5000]/title");
+
+	BENCHMARK("All titles, hand written") {
+		size_t found = 0;
+		for(auto* entry = doc.req_child("feed").child("entry"); entry; entry = entry->next("entry")) {
+			auto* type = entry->attrib("type");
+			if(!type || type->value() != "article") continue;
+			for(auto* title = entry->child("title"); title; title = title->next("title")) found++;
+		}
+		return found;
+	};
+	BENCHMARK("All titles, query") {
+		return titles.count(doc);
+	};
+	BENCHMARK("All titles, query with index") {
+		return titles.count(indexed);
+	};
+
+	BENCHMARK("5000th title, hand written") {
+		auto* entry = doc.req_child("feed").child("entry");
+		for(int i = 1; entry && i < 5000; i++) entry = entry->next("entry");
+		return entry ? entry->child("title") : nullptr;
+	};
+	BENCHMARK("5000th title, query") {
+		return nth.first(doc);
+	};
+	BENCHMARK("5000th title, query with index") {
+		return nth.first(indexed);
+	};
+}
+
+TEST_CASE("XML writing throughput vs. parsing", "[xml][benchmark]") {
+	std::string        corpus = make_corpus(16 << 20);
+	stx::xml::document doc    = stx::xml::document::parse(corpus.c_str());
+
+	auto measure = [&](const char* name, auto&& fn) {
+		fn(); // Warm up, e.g. grows the buffer
+		auto start = std::chrono::steady_clock::now();
+		constexpr int runs = 5;
+		for(int i = 0; i < runs; i++) fn();
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+		std::printf("%s: %.1f MB/s\n", name, runs * corpus.size() / seconds.count() / 1e6);
+	};
+
+	measure("document::parse", [&] {
+		stx::xml::document::parse(corpus.c_str());
+	});
+
+	stx::xml::writer buffered;
+	measure("writer, buffer", [&] {
+		buffered.clear();
+		buffered.write(doc);
+	});
+
+	stx::xml::writer pretty({ true });
+	measure("writer, pretty buffer", [&] {
+		pretty.clear();
+		pretty.write(doc);
+	});
+
+	int fd = open("/dev/null", O_WRONLY);
+	REQUIRE(fd >= 0);
+	{
+		stx::xml::writer out = stx::xml::writer::to_fd(fd);
+		measure("writer, /dev/null", [&] {
+			out.write(doc);
+			out.flush();
+		});
+	}
+	close(fd);
+
+	measure("node::print", [&] {
+		std::ostringstream s;
+		doc.print(s);
+	});
+}
+
+TEST_CASE("XML decoding: std::string copies vs. arena", "[xml][benchmark]") {
+	std::string corpus  = make_corpus(4 << 20);
+	std::string escaped = corpus;
+	for(size_t i = 0; (i = escaped.find("Some Author", i)) != std::string::npos;) {
+		escaped.replace(i, 11, "Some &amp; Author");
+	}
+
+	for(auto* text : { &corpus, &escaped }) {
+		const char* name = text == &corpus ? "nothing to decode" : "with references";
+
+		BENCHMARK(std::string("All attributes, value<std::string>, ") + name) {
+			stx::xml::document doc = stx::xml::document::parse(text->c_str());
+			size_t length = 0;
+			for(auto& entry : doc.req_child("feed")) {
+				for(auto& child : entry) {
+					for(auto* a = child.attributes(); a; a = a->next()) length += a->value<std::string>().size();
+				}
+			}
+			return length;
+		};
+		BENCHMARK(std::string("All attributes, decoded_value, ") + name) {
+			stx::xml::document doc = stx::xml::document::parse(text->c_str());
+			size_t length = 0;
+			for(auto& entry : doc.req_child("feed")) {
+				for(auto& child : entry) {
+					for(auto* a = child.attributes(); a; a = a->next()) length += a->decoded_value(doc.allocator).size();
+				}
+			}
+			return length;
+		};
+	}
+}
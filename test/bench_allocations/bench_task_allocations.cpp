@@ -0,0 +1,67 @@
+#include "../unit/catch.hpp"
+
+#include <stx/async/task_queue.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+// Counts allocations per deferred task: std::function<void()> (what executor::defer used to take) vs stx::task
+// Replacing the global operator new affects the whole executable, so this is separate from the bench executable,
+// whose allocation heavy benchmarks (e.g. object_pool vs new/delete) would pay for the counter.
+
+static std::atomic<size_t> num_allocations{0};
+
+void* operator new(size_t size) {
+	++num_allocations;
+	if(void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+template<size_t CaptureSize>
+struct capture {
+	char data[CaptureSize];
+	void operator()() const noexcept {}
+};
+
+template<size_t CaptureSize>
+void report_allocations() {
+	constexpr int num_tasks = 1000;
+
+	stx::task_queue queue;
+
+	// Before: The callback was wrapped in a std::function, which was moved into the queue
+	size_t before = num_allocations;
+	for(int i = 0; i < num_tasks; i++) {
+		std::function<void()> fn = capture<CaptureSize>();
+		queue.defer(std::move(fn));
+	}
+	size_t with_function = num_allocations - before;
+	queue.execute_tasks();
+
+	// After: The callback is moved into a stx::task directly
+	before = num_allocations;
+	for(int i = 0; i < num_tasks; i++) {
+		queue.defer(capture<CaptureSize>());
+	}
+	size_t with_task = num_allocations - before;
+	queue.execute_tasks();
+
+	std::printf(
+		"%4zu byte capture: %.2f allocations per task with std::function, %.2f with stx::task\n",
+		CaptureSize,
+		with_function / double(num_tasks),
+		with_task / double(num_tasks)
+	);
+}
+
+TEST_CASE("Allocations per deferred task", "[task][benchmark]") {
+	report_allocations<8>();
+	report_allocations<32>();
+	report_allocations<64>();
+	report_allocations<128>();
+}
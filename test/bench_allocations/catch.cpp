@@ -0,0 +1,3 @@
+#define CATCH_CONFIG_MAIN 1
+#define CATCH_CONFIG_NO_POSIX_SIGNALS 1
+#include "../unit/catch.hpp"
@@ -0,0 +1,67 @@
+#include "../catch.hpp"
+
+#include <stx/async/affinity.hpp>
+#include <stx/async/numa_threadpool.hpp>
+using namespace stx;
+
+#include <atomic>
+#include <thread>
+
+#ifdef __linux__
+	#include <pthread.h>
+#endif
+
+TEST_CASE("Test thread affinity", "[affinity]") {
+	SECTION("Parsing cpu lists") {
+		CHECK(parse_cpu_list("0-3,8,10-11\n") == cpu_set{0, 1, 2, 3, 8, 10, 11});
+		CHECK(parse_cpu_list("5") == cpu_set{5});
+		CHECK(parse_cpu_list("").empty());
+	}
+
+	SECTION("There is at least one NUMA node with at least one CPU") {
+		auto nodes = numa_nodes();
+		REQUIRE(!nodes.empty());
+		for(auto& node : nodes) CHECK(!node.empty());
+	}
+
+#ifdef __linux__
+	SECTION("Workers are named and pinned") {
+		int cpu = current_cpu();
+		REQUIRE(cpu >= 0);
+
+		thread_options options;
+		options.name         = "worker";
+		options.cpus         = { cpu };
+		options.one_cpu_each = true;
+
+		std::atomic<int>  ran_on{-1};
+		std::atomic<bool> done{false};
+		char name[16] = {};
+		{
+			threadpool pool(1, options);
+			pool.defer([&]() {
+				pthread_getname_np(pthread_self(), name, sizeof(name));
+				ran_on = current_cpu();
+				done   = true;
+			});
+			while(!done) std::this_thread::yield();
+		}
+		CHECK(std::string(name) == "worker-0");
+		CHECK(ran_on == cpu);
+	}
+#endif
+
+	SECTION("numa_threadpool runs tasks") {
+		numa_threadpool pool(1);
+		CHECK(pool.num_nodes() >= 1);
+		CHECK(pool.current_node() < pool.num_nodes());
+
+		std::atomic<int> remaining{100};
+		for(int i = 0; i < 100; i++) {
+			pool.defer([&]() { remaining--; });
+		}
+		pool.node(pool.num_nodes() - 1).defer([&]() { remaining--; });
+		while(remaining > -1) std::this_thread::yield();
+		CHECK(remaining == -1);
+	}
+}
@@ -0,0 +1,115 @@
+#include "../catch.hpp"
+
+#include <stx/async/coro.hpp>
+
+#ifdef STX_HAS_COROUTINES
+
+#include <stx/async/task_queue.hpp>
+#include <stx/async/threadpool.hpp>
+
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+static stx::coro_task<int> answer() {
+	co_return 42;
+}
+
+static stx::coro_task<int> add_to_answer(int i) {
+	int a = co_await answer();
+	co_return a + i;
+}
+
+static stx::coro_task<void> throwing() {
+	throw std::runtime_error("oops");
+	co_return;
+}
+
+TEST_CASE("Test coro_task", "[coro]") {
+	SECTION("Awaiting other coroutines") {
+		CHECK(add_to_answer(1).get() == 43);
+	}
+
+	SECTION("Exceptions propagate") {
+		auto catching = []() -> stx::coro_task<bool> {
+			try { co_await throwing(); }
+			catch(std::runtime_error&) { co_return true; }
+			co_return false;
+		};
+		CHECK(catching().get());
+		CHECK_THROWS_AS(throwing().get(), std::runtime_error);
+	}
+
+	SECTION("Hopping onto executors") {
+		stx::task_queue queue;
+		int state = 0;
+
+		auto fn = [&]() -> stx::coro_task<void> {
+			state = 1;
+			co_await queue;
+			state = 2;
+		};
+
+		auto f = fn().start();
+		CHECK(state == 1);
+		CHECK(!f.ready());
+		queue.execute_tasks();
+		CHECK(state == 2);
+		CHECK(f.ready());
+	}
+
+	SECTION("Awaiting futures") {
+		stx::promise<int> p;
+		auto fn = [&]() -> stx::coro_task<int> {
+			co_return co_await p.get_future() * 2;
+		};
+
+		auto f = fn().start();
+		CHECK(!f.ready());
+		p.set_value(21);
+		CHECK(f.get() == 42);
+	}
+
+	SECTION("Pipelines across threads") {
+		stx::threadpool pool(2);
+		auto fn = [&]() -> stx::coro_task<std::thread::id> {
+			co_await pool;
+			co_return std::this_thread::get_id();
+		};
+		CHECK(fn().get() != std::this_thread::get_id());
+	}
+}
+
+TEST_CASE("Test coro_task with sockets", "[coro][socket]") {
+	std::string_view msg = "Hello there\n";
+	uint16_t port = 31416;
+
+	stx::socket server;
+	REQUIRE(server.open(stx::domain::ipv4, stx::socktype::tcp));
+	REQUIRE(server.option(stx::sockopt::reuse_port, true));
+	REQUIRE(server.bind(stx::ipv4(port)));
+	REQUIRE(server.listen(1));
+
+	stx::socket client;
+	REQUIRE(client.open(stx::domain::ipv4, stx::socktype::tcp));
+	REQUIRE(client.connect(stx::ipv4(127,0,0,1, port)));
+
+	stx::socket connection = server.accept();
+	REQUIRE(connection);
+
+	auto receive = [&]() -> stx::coro_task<std::string> {
+		co_await stx::readable(connection);
+		char buffer[64] = {'\0'};
+		int length = connection.recv(buffer, sizeof(buffer));
+		co_return std::string(buffer, std::max(0, length));
+	};
+
+	auto received = receive().start();
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	CHECK(!received.ready());
+
+	client.send(msg);
+	CHECK(received.get() == msg);
+}
+
+#endif // STX_HAS_COROUTINES
@@ -0,0 +1,139 @@
+#include "../catch.hpp"
+
+#include <stx/async/future.hpp>
+#include <stx/async/task_queue.hpp>
+#include <stx/async/threadpool.hpp>
+
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("Test future", "[future]") {
+	SECTION("Continuations run inline when the value is already there") {
+		int result = 0;
+		stx::make_ready_future<int>(20)
+			.then([](int i) { return i * 2; })
+			.then([&](int i) { result = i + 2; });
+		CHECK(result == 42);
+	}
+
+	SECTION("Continuations run once the promise is fulfilled") {
+		stx::promise<std::string> p;
+		std::string result;
+		p.get_future().then([&](std::string s) { result = s; });
+		CHECK(result.empty());
+		p.set_value("hello");
+		CHECK(result == "hello");
+	}
+
+	SECTION("Continuations can run on an executor") {
+		stx::task_queue queue;
+		auto f = stx::make_ready_future<int>(1).then(queue, [](int i) { return i + 1; });
+		CHECK(!f.ready());
+		queue.execute_tasks();
+		REQUIRE(f.ready());
+		CHECK(f.get() == 2);
+	}
+
+	SECTION("Futures returned by continuations are unwrapped") {
+		stx::promise<int> inner;
+		stx::future<int> f = stx::make_ready_future().then([&]() { return inner.get_future(); });
+		CHECK(!f.ready());
+		inner.set_value(7);
+		CHECK(f.get() == 7);
+	}
+
+	SECTION("Errors skip then() and are handled by fail()") {
+		bool skipped = true;
+		std::string message;
+		auto f = stx::make_ready_future<int>(1)
+			.then([](int) -> int { throw std::runtime_error("oops"); })
+			.then([&](int i) { skipped = false; return i; })
+			.fail([&](std::exception_ptr e) {
+				try { std::rethrow_exception(e); }
+				catch(std::exception& ex) { message = ex.what(); }
+				return -1;
+			});
+		CHECK(skipped);
+		CHECK(message == "oops");
+		CHECK(f.get() == -1);
+	}
+
+	SECTION("get() rethrows errors") {
+		auto f = stx::make_failed_future<void>(std::make_exception_ptr(std::runtime_error("oops")));
+		CHECK_THROWS_AS(f.get(), std::runtime_error);
+	}
+
+	SECTION("Dropping a promise breaks it") {
+		stx::future<int> f;
+		{
+			stx::promise<int> p;
+			f = p.get_future();
+		}
+		CHECK_THROWS_AS(f.get(), std::future_error);
+	}
+
+	SECTION("when_all") {
+		stx::promise<int> a, b;
+		std::vector<stx::future<int>> futures;
+		futures.push_back(a.get_future());
+		futures.push_back(b.get_future());
+
+		auto all = stx::when_all(std::move(futures));
+		b.set_value(2);
+		CHECK(!all.ready());
+		a.set_value(1);
+		CHECK(all.get() == std::vector<int>{1, 2});
+
+		auto tuple = stx::when_all(stx::make_ready_future<int>(1), stx::make_ready_future<std::string>("two"), stx::make_ready_future());
+		auto [one, two, three] = tuple.get();
+		CHECK(one == 1);
+		CHECK(two == "two");
+		(void) three;
+	}
+
+	SECTION("when_all fails with the first error") {
+		stx::promise<void> a, b;
+		std::vector<stx::future<void>> futures;
+		futures.push_back(a.get_future());
+		futures.push_back(b.get_future());
+
+		auto all = stx::when_all(std::move(futures));
+		b.set_error(std::make_exception_ptr(std::runtime_error("oops")));
+		REQUIRE(all.ready());
+		CHECK_THROWS_AS(all.get(), std::runtime_error);
+		a.set_value();
+	}
+
+	SECTION("when_any") {
+		stx::promise<int> a, b;
+		std::vector<stx::future<int>> futures;
+		futures.push_back(a.get_future());
+		futures.push_back(b.get_future());
+
+		auto any = stx::when_any(std::move(futures));
+		CHECK(!any.ready());
+		b.set_value(2);
+		a.set_value(1);
+		auto [index, value] = any.get();
+		CHECK(index == 1);
+		CHECK(value == 2);
+	}
+
+	SECTION("Pipelines across threads") {
+		stx::threadpool pool(4);
+		stx::task_queue main_thread;
+
+		std::vector<stx::future<int>> futures;
+		for(int i = 0; i < 100; i++) {
+			futures.push_back(stx::defer(pool, [i]() { return i; }).then(pool, [](int i) { return i * 2; }));
+		}
+		auto sum = stx::when_all(std::move(futures)).then(main_thread, [](std::vector<int> values) {
+			int sum = 0;
+			for(int v : values) sum += v;
+			return sum;
+		});
+
+		while(!sum.ready()) main_thread.execute_tasks();
+		CHECK(sum.get() == 99 * 100);
+	}
+}
@@ -0,0 +1,88 @@
+#include "../catch.hpp"
+
+#include <stx/async/instrumented_executor.hpp>
+#include <stx/async/task_queue.hpp>
+#include <stx/async/threadpool.hpp>
+using namespace stx;
+
+#include <atomic>
+#include <chrono>
+using namespace std::chrono;
+using namespace std::chrono_literals;
+#include <thread>
+
+TEST_CASE("Test instrumented_executor", "[instrumented_executor]") {
+	SECTION("Histogram percentiles") {
+		latency_histogram h;
+		CHECK(h.count() == 0);
+		CHECK(h.percentile(0.5) == 0ns);
+
+		h.buckets[3]  = 90; // [8ns, 16ns)
+		h.buckets[10] = 10; // [1024ns, 2048ns)
+		CHECK(h.count() == 100);
+		CHECK(h.percentile(0)    == 16ns);
+		CHECK(h.percentile(0.5)  == 16ns);
+		CHECK(h.percentile(0.95) == 2048ns);
+		CHECK(h.percentile(1)    == 2048ns);
+	}
+
+#if STX_ASYNC_STATS
+	SECTION("Counters and queue depth") {
+		task_queue queue;
+		instrumented_executor instrumented(queue);
+
+		int n = 0;
+		for(int i = 0; i < 10; i++) {
+			instrumented.defer([&]() { n++; });
+		}
+
+		auto before = instrumented.stats();
+		CHECK(before.deferred        == 10);
+		CHECK(before.started         == 0);
+		CHECK(before.queue_depth     == 10);
+		CHECK(before.max_queue_depth == 10);
+
+		queue.execute_tasks();
+		CHECK(n == 10);
+
+		auto after = instrumented.stats();
+		CHECK(after.started         == 10);
+		CHECK(after.finished        == 10);
+		CHECK(after.queue_depth     == 0);
+		CHECK(after.running         == 0);
+		CHECK(after.max_running     == 1);
+		CHECK(after.wait_time.count() == 10);
+		CHECK(after.run_time.count()  == 10);
+
+		instrumented.reset_stats();
+		auto reset = instrumented.stats();
+		CHECK(reset.deferred          == 10);
+		CHECK(reset.max_queue_depth   == 0);
+		CHECK(reset.wait_time.count() == 0);
+	}
+
+	SECTION("Run time is recorded") {
+		task_queue queue;
+		instrumented_executor instrumented(queue);
+		instrumented.defer([]() { std::this_thread::sleep_for(2ms); });
+		queue.execute_tasks();
+		CHECK(instrumented.stats().run_time.percentile(1) >= 2ms);
+	}
+
+	SECTION("Concurrent use") {
+		std::atomic<int> remaining{1000};
+		threadpool pool(4);
+		instrumented_executor instrumented(pool);
+		for(int i = 0; i < 1000; i++) {
+			instrumented.defer([&]() { remaining--; });
+		}
+		while(remaining > 0) std::this_thread::yield();
+		pool.stop();
+
+		auto stats = instrumented.stats();
+		CHECK(stats.finished        == 1000);
+		CHECK(stats.max_running     <= 4);
+		CHECK(stats.max_queue_depth <= 1000);
+	}
+#endif
+}
@@ -0,0 +1,109 @@
+#include "../catch.hpp"
+
+#include <stx/async/parallel.hpp>
+#include <stx/async/threadpool.hpp>
+using namespace stx;
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Test parallel algorithms", "[parallel]") {
+	threadpool pool(4);
+
+	SECTION("parallel_for visits every index exactly once") {
+		std::vector<std::atomic<int>> visited(10000);
+		parallel_for(pool, 0, visited.size(), 16, [&](size_t i) { visited[i]++; });
+		for(auto& v : visited) REQUIRE(v == 1);
+	}
+
+	SECTION("parallel_for with chunks and automatic grain") {
+		std::atomic<size_t> sum{0};
+		parallel_for(pool, 100, 1100, 0, [&](size_t begin, size_t end) {
+			CHECK(begin < end);
+			size_t local = 0;
+			for(size_t i = begin; i < end; i++) local += i;
+			sum += local;
+		});
+		CHECK(sum == (100 + 1099) * 1000 / 2);
+	}
+
+	SECTION("Empty and tiny ranges run on the caller") {
+		int n = 0;
+		parallel_for(pool, 5, 5, 1, [&](size_t) { n++; });
+		CHECK(n == 0);
+		parallel_for(pool, 0, 3, 100, [&](size_t) { n++; });
+		CHECK(n == 3);
+	}
+
+	SECTION("Participants come from the executor's threads, not the CPU count") {
+		CHECK(pool.num_threads() == 4);
+
+		std::mutex                mutex;
+		std::set<std::thread::id> threads;
+		parallel_for(pool, 0, 5, 1, [&](size_t) {
+			{ std::scoped_lock lock{mutex};
+				threads.insert(std::this_thread::get_id());
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(20)); // Gives the other participants time to claim a chunk
+		});
+		CHECK(threads.size() > 1);
+
+		executor inline_executor;
+		threads.clear();
+		parallel_for(inline_executor, 0, 100, 1, [&](size_t) { threads.insert(std::this_thread::get_id()); });
+		CHECK(threads == std::set<std::thread::id>{ std::this_thread::get_id() });
+	}
+
+	SECTION("Nested parallel_for from within the pool does not deadlock") {
+		std::atomic<int> n{0};
+		parallel_for(pool, 0, 16, 1, [&](size_t) {
+			parallel_for(pool, 0, 100, 1, [&](size_t) { n++; });
+		});
+		CHECK(n == 1600);
+	}
+
+	SECTION("Exceptions are rethrown to the caller") {
+		CHECK_THROWS_AS(
+			parallel_for(pool, 0, 1000, 1, [](size_t i) { if(i == 500) throw std::runtime_error("fail"); }),
+			std::runtime_error
+		);
+	}
+
+	SECTION("parallel_reduce") {
+		size_t sum = parallel_reduce(pool, 0, 100000, 64, size_t(0),
+			[](size_t acc, size_t i) { return acc + i; },
+			[](size_t a, size_t b) { return a + b; }
+		);
+		CHECK(sum == size_t(99999) * 100000 / 2);
+	}
+
+	SECTION("parallel_transform") {
+		std::vector<int> in(1000), out(1000);
+		std::iota(in.begin(), in.end(), 0);
+		auto end = parallel_transform(pool, in.begin(), in.end(), out.begin(), 10, [](int x) { return x * 2; });
+		CHECK(end == out.end());
+		for(int i = 0; i < 1000; i++) REQUIRE(out[i] == i * 2);
+	}
+
+	SECTION("parallel_each over bitmaps") {
+		std::vector<int> pixels(16 * 10, -1);
+		bitmap<int> image(pixels.data(), 16, 10);
+		parallel_each(pool, image.subimage(2, 1, 10, 8), [](int& p, unsigned x, unsigned y) { p = int(x + y * 100); }, 1);
+		CHECK(image(2, 1) == 0);
+		CHECK(image(11, 8) == 9 + 7 * 100);
+		CHECK(image(1, 1) == -1);
+		CHECK(image(12, 1) == -1);
+		CHECK(image(2, 9) == -1);
+
+		std::vector<int> voxels(8 * 8 * 8, 0);
+		bitmap3d<int> volume(voxels.data(), 8, 8, 8);
+		parallel_each(pool, volume, [](int& v, unsigned x, unsigned y, unsigned z) { v = int(x + y * 8 + z * 64); });
+		for(int i = 0; i < 512; i++) REQUIRE(voxels[i] == i);
+	}
+}
@@ -0,0 +1,105 @@
+#include "../catch.hpp"
+
+#include <stx/async/priority_task_queue.hpp>
+using namespace stx;
+
+#include <atomic>
+#include <cmath>
+#include <chrono>
+using namespace std::chrono;
+using namespace std::chrono_literals;
+#include <thread>
+#include <vector>
+
+TEST_CASE("Test priority_task_queue", "[priority_task_queue]") {
+	SECTION("Float priorities map onto levels") {
+		constexpr int mid = priority_task_queue::num_levels / 2;
+		CHECK(priority_task_queue::level_of(0)     == mid);
+		CHECK(priority_task_queue::level_of(0.5f)  == mid);
+		CHECK(priority_task_queue::level_of(-0.5f) == mid - 1);
+		CHECK(priority_task_queue::level_of(2)     == mid + 2);
+		CHECK(priority_task_queue::level_of(-1000) == 0);
+		CHECK(priority_task_queue::level_of(1000)  == priority_task_queue::num_levels - 1);
+		CHECK(priority_task_queue::level_of(NAN)   == 0);
+	}
+
+	SECTION("Lower priorities run first, equal priorities in order") {
+		priority_task_queue queue;
+		std::vector<int> order;
+		queue.defer([&]() { order.push_back(3); }, 5);
+		queue.defer([&]() { order.push_back(1); }, -2);
+		queue.defer([&]() { order.push_back(2); });
+		queue.defer([&]() { order.push_back(4); }, 5);
+		CHECK(queue.size() == 4);
+		CHECK(queue.execute_tasks());
+		CHECK(order == std::vector<int>{1, 2, 3, 4});
+		CHECK(!queue.execute_tasks());
+	}
+
+	SECTION("Levels out of range are clamped") {
+		priority_task_queue queue;
+		std::vector<int> order;
+		queue.defer_level([&]() { order.push_back(2); }, priority_task_queue::num_levels);
+		queue.defer_level([&]() { order.push_back(1); }, -1);
+		queue.defer_level([&]() { order.push_back(3); }, 1000);
+		queue.set_deadline(-1, 1ms);
+		queue.set_deadline(priority_task_queue::num_levels, 1ms);
+		CHECK(queue.size() == 3);
+		queue.execute_tasks();
+		CHECK(order == std::vector<int>{1, 2, 3});
+	}
+
+	SECTION("Urgent tasks jump ahead of queued bulk work") {
+		priority_task_queue queue;
+		std::vector<int> order;
+		queue.defer([&]() {
+			order.push_back(1);
+			queue.defer([&]() { order.push_back(2); }, -5);
+		}, 5);
+		queue.defer([&]() { order.push_back(3); }, 5);
+		queue.execute_tasks();
+		CHECK(order == std::vector<int>{1, 2, 3});
+	}
+
+	SECTION("Time budget") {
+		priority_task_queue queue;
+		int n = 0;
+		for(int i = 0; i < 10; i++) {
+			queue.defer([&]() { n++; std::this_thread::sleep_for(1ms); });
+		}
+		CHECK(queue.execute_tasks(priority_task_queue::clock::now()));
+		CHECK(n == 1);
+		queue.execute_tasks();
+		CHECK(n == 10);
+	}
+
+	SECTION("Deadline mode runs the earliest deadline first") {
+		priority_task_queue queue(priority_task_queue::deadline);
+		queue.set_deadline(0, 10ms);
+		std::vector<int> order;
+		queue.defer_level([&]() { order.push_back(1); }, 5); // Deadline ~3.2ms
+		queue.defer_level([&]() { order.push_back(2); }, 0); // Deadline 10ms
+		std::this_thread::sleep_for(1ms);
+		queue.defer_level([&]() { order.push_back(3); }, 1); // Deadline ~1.2ms
+		queue.execute_tasks();
+		CHECK(order == std::vector<int>{3, 1, 2});
+	}
+
+	SECTION("Adding tasks & executing in parallel") {
+		std::atomic<int> balance{0};
+		std::vector<std::thread> threads;
+		{
+			priority_task_queue queue;
+			for(int i = 0; i < 4; i++) {
+				threads.emplace_back([&]() { queue.start(); });
+			}
+			for(int i = 0; i < 1000; i++) {
+				balance++;
+				queue.defer([&]() { balance--; }, float(i % 20 - 10));
+			}
+			std::this_thread::sleep_for(10ms);
+		}
+		for(auto& thread : threads) thread.join();
+		CHECK(balance == 0);
+	}
+}
@@ -1,8 +1,11 @@
 #include "../catch.hpp"
 
 #include <stx/async/task.hpp>
+#include <stx/async/future.hpp>
 #include <stx/async/task_queue.hpp>
 
+#include "../test_helpers/counted.hpp"
+
 TEST_CASE("Test task composition", "[task]") {
 	stx::task_queue q1;
 	stx::task_queue q2;
@@ -13,8 +16,7 @@ TEST_CASE("Test task composition", "[task]") {
 
 	State state = A;
 
-	/*
-	defer(q1, [&]() {
+	stx::defer(q1, [&]() {
 		state = B;
 	})
 	.then(q2, [&]() {
@@ -29,5 +31,44 @@ TEST_CASE("Test task composition", "[task]") {
 	CHECK(state == B);
 	q2.execute_tasks(); // task C and D are both executed
 	CHECK(state == D);
-	*/
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test task", "[task]") {
+	SECTION("Empty tasks") {
+		stx::task t;
+		CHECK(!t);
+		t = nullptr;
+		CHECK(!t);
+		CHECK(!stx::task(std::function<void()>()));
+	}
+
+	SECTION("Small callables are stored inline") {
+		struct big { char data[STX_TASK_INLINE_SIZE + 1]; void operator()() {} };
+		auto small = [p = (void*)nullptr]() { (void)p; };
+		CHECK(stx::task::stored_inline<decltype(small)>);
+		CHECK(!stx::task::stored_inline<big>);
+	}
+
+	SECTION("Tasks are moved and destroyed correctly") {
+		int alive = 0;
+		int calls = 0;
+		{
+			struct big { char data[STX_TASK_INLINE_SIZE + 1]; };
+			counted c(alive);
+			big b{};
+			stx::task small([&calls, c = std::move(c)]() { calls++; });
+			stx::task large([&calls, c = counted(alive), b]() { calls++; });
+			CHECK(alive == 2);
+
+			stx::task moved = std::move(small);
+			CHECK(!small);
+			moved();
+			large();
+			CHECK(calls == 2);
+
+			large = std::move(moved);
+			CHECK(alive == 1);
+		}
+		CHECK(alive == 0);
+	}
+}
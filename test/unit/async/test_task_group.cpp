@@ -0,0 +1,120 @@
+#include "../catch.hpp"
+
+#include <stx/async/task_group.hpp>
+#include <stx/async/task_queue.hpp>
+#include <stx/async/threadpool.hpp>
+using namespace stx;
+
+#include <atomic>
+#include <chrono>
+using namespace std::chrono_literals;
+#include <stdexcept>
+#include <thread>
+
+TEST_CASE("Test cancellation", "[task_group]") {
+	SECTION("Tokens") {
+		cancellation_token never;
+		CHECK(!never.cancelled());
+
+		cancellation_source source;
+		auto token = source.token();
+		CHECK(!token.cancelled());
+		source.cancel();
+		CHECK(token.cancelled());
+		CHECK_THROWS_AS(token.throw_if_cancelled(), task_cancelled);
+	}
+
+	SECTION("Child sources are cancelled with their parent") {
+		cancellation_source parent;
+		cancellation_source child(parent.token());
+		CHECK(!child.cancelled());
+		parent.cancel();
+		CHECK(child.cancelled());
+	}
+
+	SECTION("Tokens and weak<T> guard deferred tasks") {
+		task_queue queue;
+		cancellation_source source;
+		auto object = stx::make_shared<int>(0);
+
+		int n = 0;
+		queue.defer([&]() { n++; }, source.token(), 0);
+		queue.defer([&]() { n++; }, stx::weak<int>(object), 0);
+		queue.execute_tasks();
+		CHECK(n == 2);
+
+		queue.defer([&]() { n++; }, source.token(), 0);
+		queue.defer([&]() { n++; }, stx::weak<int>(object), 0);
+		source.cancel();
+		object.reset();
+		queue.execute_tasks();
+		CHECK(n == 2);
+	}
+}
+
+TEST_CASE("Test task_group", "[task_group]") {
+	threadpool pool(4);
+
+	SECTION("Waiting for all tasks") {
+		std::atomic<int> n{0};
+		task_group group(pool);
+		for(int i = 0; i < 100; i++) {
+			group.run([&]() { n++; });
+		}
+		group.wait();
+		CHECK(n == 100);
+	}
+
+	SECTION("wait() runs pending tasks itself") {
+		task_queue queue; // Never executed by anyone else
+		task_group group(queue);
+		int n = 0;
+		group.run([&]() { n++; });
+		group.run([&]() { n++; });
+		group.wait();
+		CHECK(n == 2);
+		queue.execute_tasks(); // The deferred runners find nothing left to do
+		CHECK(n == 2);
+	}
+
+	SECTION("First exception is rethrown and cancels the rest") {
+		task_queue queue;
+		task_group group(queue);
+		int n = 0;
+		group.run([&]() { n++; });
+		group.run([&]() { throw std::runtime_error("first"); });
+		group.run([&]() { throw std::logic_error("second"); });
+		group.run([&]() { n++; });
+		CHECK_THROWS_AS(group.wait(), std::runtime_error);
+		CHECK(n == 1);
+		CHECK(group.cancelled());
+		CHECK_NOTHROW(group.wait());
+	}
+
+	SECTION("Cooperative cancellation") {
+		std::atomic<bool> started{false};
+		std::atomic<bool> stopped_early{false};
+		task_group group(pool);
+		group.run([&](cancellation_token token) {
+			started = true;
+			while(!token.cancelled()) std::this_thread::yield();
+			stopped_early = true;
+			token.throw_if_cancelled(); // Not reported as an error
+		});
+		while(!started) std::this_thread::yield();
+		group.cancel();
+		CHECK_NOTHROW(group.wait());
+		CHECK(stopped_early);
+	}
+
+	SECTION("Groups are cancelled along with their parent") {
+		cancellation_source request;
+		task_queue queue;
+		task_group group(queue, request.token());
+		int n = 0;
+		group.run([&]() { n++; });
+		request.cancel();
+		group.wait();
+		CHECK(n == 0);
+	}
+}
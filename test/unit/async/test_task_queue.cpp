@@ -1,12 +1,15 @@
 #include "../catch.hpp"
 
 #include <stx/async/task_queue.hpp>
+#include <stx/async/threadpool.hpp>
 using namespace stx;
 
 #include <chrono>
 using namespace std::chrono;
 using namespace std::chrono_literals;
 #include <thread>
+#include <vector>
+#include <atomic>
 
 auto THREADING_STRESSTEST_DURATION = 30ms;
 
@@ -45,6 +48,40 @@ TEST_CASE("Test task_queue", "[task_queue]") {
 		queue.execute_tasks();
 		CHECK(balance == 0);
 	}
+
+	SECTION("Timers run once they are due") {
+		std::vector<int> order;
+		queue.defer_after(2ms, [&]() { order.push_back(2); });
+		queue.defer_at(steady_clock::now(), [&]() { order.push_back(1); });
+		auto cancelled = queue.defer_after(1ms, [&]() { order.push_back(-1); });
+		cancelled.cancel();
+		CHECK(cancelled.cancelled());
+
+		queue.execute_tasks();
+		CHECK(order == std::vector<int>{1});
+		REQUIRE(queue.next_timer());
+		CHECK(*queue.next_timer() > steady_clock::now());
+
+		std::this_thread::sleep_until(*queue.next_timer());
+		queue.execute_tasks();
+		CHECK(order == std::vector<int>{1, 2});
+		CHECK(!queue.next_timer());
+	}
+
+	SECTION("Periodic timers until cancelled") {
+		int n = 0;
+		auto timer = queue.defer_every(1ms, [&]() { n++; });
+		for(int i = 0; i < 3; i++) {
+			std::this_thread::sleep_for(1ms);
+			queue.execute_tasks();
+		}
+		CHECK(n == 3);
+		timer.cancel();
+		std::this_thread::sleep_for(1ms);
+		queue.execute_tasks();
+		CHECK(n == 3);
+		CHECK(!queue.next_timer());
+	}
 }
 
 TEST_CASE("Test task_queue_mt", "[task_queue]") {
@@ -119,4 +156,96 @@ TEST_CASE("Test task_queue_mt", "[task_queue]") {
 
 		CHECK(balance == 0);
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test stopping and restarting task_queue_mt", "[task_queue]") {
+	SECTION("start() after stop() runs tasks again") {
+		task_queue_mt queue;
+		for(int round = 0; round < 3; round++) {
+			std::atomic<int> n{0};
+			std::thread worker([&]() { queue.start(); });
+			queue.defer([&]() { n++; });
+			while(n == 0) std::this_thread::yield();
+			queue.stop();
+			worker.join();
+			CHECK(n == 1);
+		}
+	}
+
+	SECTION("threadpool start() after stop()") {
+		threadpool pool(2);
+		pool.stop();
+		pool.start(2);
+
+		std::atomic<int> n{0};
+		pool.defer([&]() { n++; });
+		while(n == 0) std::this_thread::yield();
+		CHECK(pool.num_threads() == 2);
+	}
+
+	SECTION("Stopping a threadpool before its threads started running tasks") {
+		for(int i = 0; i < 20; i++) {
+			threadpool pool(4); // Destroyed right away, before most workers get to work()
+		}
+		SUCCEED();
+	}
+}
+
+TEST_CASE("Test task_queue_mt timers", "[task_queue]") {
+	SECTION("Sleeping workers wake up when a timer is due") {
+		std::vector<std::thread> threads;
+		std::atomic<int> done{0};
+		steady_clock::time_point ran_at;
+		{
+			task_queue_mt queue;
+			for(int i = 0; i < 4; i++) {
+				threads.emplace_back([&]() { queue.start(); });
+			}
+			std::this_thread::sleep_for(5ms); // All workers are asleep
+
+			auto due = steady_clock::now() + 10ms;
+			queue.defer_at(due, [&]() { ran_at = steady_clock::now(); done++; });
+			queue.defer_after(5ms, [&]() { done++; }); // Earlier than the first timer
+			queue.defer_after(1h, [&]() { done += 100; }); // Dropped by stop()
+			auto cancelled = queue.defer_after(1ms, [&]() { done += 100; });
+			cancelled.cancel();
+
+			while(done < 2) std::this_thread::yield();
+			CHECK(ran_at >= due);
+			CHECK(ran_at < due + 100ms);
+		}
+		for(auto& thread : threads) thread.join();
+		CHECK(done == 2);
+	}
+
+	SECTION("Another worker takes over waiting for timers while the timer worker runs a task") {
+		threadpool pool(2);
+		std::this_thread::sleep_for(5ms); // Both workers are asleep
+
+		std::atomic<bool> done{false};
+		steady_clock::time_point ran_at;
+		auto start = steady_clock::now();
+		pool.defer_after(10ms, [&]() { std::this_thread::sleep_for(300ms); });
+		pool.defer_after(50ms, [&]() { ran_at = steady_clock::now(); done = true; });
+
+		while(!done) std::this_thread::yield();
+		CHECK(ran_at - start >= 50ms);
+		CHECK(ran_at - start < 250ms);
+	}
+
+	SECTION("Periodic timers") {
+		std::atomic<int> n{0};
+		std::vector<std::thread> threads;
+		{
+			task_queue_mt queue;
+			for(int i = 0; i < 2; i++) {
+				threads.emplace_back([&]() { queue.start(); });
+			}
+			auto timer = queue.defer_every(1ms, [&]() { n++; });
+			while(n < 5) std::this_thread::yield();
+			timer.cancel();
+		}
+		for(auto& thread : threads) thread.join();
+		CHECK(n >= 5);
+	}
+}
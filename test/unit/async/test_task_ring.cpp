@@ -0,0 +1,101 @@
+#include "../catch.hpp"
+
+#include <stx/async/task_ring.hpp>
+using namespace stx;
+
+#include <atomic>
+#include <chrono>
+using namespace std::chrono;
+using namespace std::chrono_literals;
+#include <thread>
+#include <vector>
+
+TEST_CASE("Test task_ring", "[task_ring]") {
+	SECTION("Capacity is rounded up to a power of two") {
+		task_ring ring(100);
+		CHECK(ring.capacity() == 128);
+	}
+
+	SECTION("All tasks are executed in order") {
+		task_ring ring(16);
+		std::vector<int> order;
+		for(int i = 0; i < 10; i++) {
+			ring.defer([&order, i]() { order.push_back(i); });
+		}
+		CHECK(ring.execute_tasks());
+		CHECK(order == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+		CHECK(!ring.execute_tasks());
+	}
+
+	SECTION("Rejecting tasks when full") {
+		task_ring ring(4, task_ring::reject);
+		int n = 0;
+		for(int i = 0; i < 6; i++) {
+			ring.defer([&]() { n++; });
+		}
+		CHECK(ring.num_rejected() == 2);
+		CHECK(!ring.try_defer([&]() { n++; }));
+		ring.execute_tasks();
+		CHECK(n == 4);
+		CHECK(ring.try_defer([&]() { n++; }));
+	}
+
+	SECTION("Deferring into a full ring from within a task") {
+		for(auto policy : { task_ring::block, task_ring::spin }) {
+			task_ring ring(2, policy);
+			int n = 0;
+			ring.defer([&]() {
+				for(int i = 0; i < 10; i++) ring.defer([&]() { n++; }); // No other consumer would make room
+			});
+			ring.execute_tasks();
+			CHECK(n == 10);
+		}
+	}
+
+	SECTION("Every consumer fanning out into a full ring") {
+		std::atomic<int> n{0};
+		std::vector<std::thread> threads;
+		{
+			task_ring ring(4);
+			for(size_t i = 0; i < 2; i++) {
+				threads.emplace_back([&]() { ring.start(); });
+			}
+			for(int i = 0; i < 4; i++) {
+				ring.defer([&]() {
+					for(int j = 0; j < 100; j++) ring.defer([&]() { n++; });
+				});
+			}
+			while(n < 400) std::this_thread::yield();
+		}
+		for(auto& thread : threads) thread.join();
+		CHECK(n == 400);
+	}
+
+	SECTION("Adding tasks & executing in parallel") {
+		for(auto policy : { task_ring::block, task_ring::spin }) {
+			std::atomic<int> balance{0};
+			std::vector<std::thread> threads;
+			{
+				task_ring ring(64, policy);
+
+				for(size_t i = 0; i < 4; i++) {
+					threads.emplace_back([&]() { ring.start(); });
+				}
+
+				auto end = steady_clock::now() + 30ms;
+				std::vector<std::thread> producers;
+				for(size_t i = 0; i < 10; i++) {
+					producers.emplace_back([&]() {
+						while(steady_clock::now() < end) {
+							balance++;
+							ring.defer([&]() { balance--; });
+						}
+					});
+				}
+				for(auto& thread : producers) thread.join();
+			}
+			for(auto& thread : threads) thread.join();
+			CHECK(balance == 0);
+		}
+	}
+}
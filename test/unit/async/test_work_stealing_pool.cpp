@@ -0,0 +1,68 @@
+#include "../catch.hpp"
+
+#include <stx/async/work_stealing_pool.hpp>
+using namespace stx;
+
+#include <chrono>
+using namespace std::chrono;
+using namespace std::chrono_literals;
+#include <thread>
+
+TEST_CASE("Test work_stealing_pool", "[work_stealing_pool]") {
+	SECTION("All tasks are executed") {
+		std::atomic<int> n{1000};
+		{
+			work_stealing_pool pool(4);
+			for(int i = 0; i < 1000; i++) {
+				pool.defer([&]() { n--; });
+			}
+		}
+		CHECK(n == 0);
+	}
+
+	SECTION("Tasks deferred before start are executed") {
+		std::atomic<int> n{10};
+		work_stealing_pool pool;
+		for(int i = 0; i < 10; i++) {
+			pool.defer([&]() { n--; });
+		}
+		pool.start(2);
+		pool.stop();
+		CHECK(n == 0);
+	}
+
+	SECTION("Tasks deferred from workers are executed") {
+		std::atomic<int> n{0};
+		{
+			work_stealing_pool pool(4);
+			for(int i = 0; i < 100; i++) {
+				pool.defer([&]() {
+					for(int j = 0; j < 100; j++) {
+						pool.defer([&]() { n++; });
+					}
+				});
+			}
+		}
+		CHECK(n == 100 * 100);
+	}
+
+	SECTION("Adding tasks & executing in parallel") {
+		std::atomic<int> balance{0};
+		{
+			work_stealing_pool pool(4);
+
+			auto end = steady_clock::now() + 30ms;
+			std::vector<std::thread> threads;
+			for(size_t i = 0; i < 10; i++) {
+				threads.emplace_back([&]() {
+					while(steady_clock::now() < end) {
+						balance++;
+						pool.defer([&]() { balance--; });
+					}
+				});
+			}
+			for(auto& thread : threads) thread.join();
+		}
+		CHECK(balance == 0);
+	}
+}
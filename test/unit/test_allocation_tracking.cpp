@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include <stx/allocation_tracking.hpp>
+#include <stx/allocator.hpp>
+#include <stx/object_pool.hpp>
+#include <stx/shared.hpp>
+using namespace stx;
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+struct tracked_widget {
+	int value[8];
+};
+
+allocation_stats _find(std::string const& name) {
+	auto report = allocation_report();
+	auto it = std::find_if(report.begin(), report.end(), [&](auto& s) { return s.name == name; });
+	REQUIRE(it != report.end());
+	return *it;
+}
+
+} // namespace
+
+TEST_CASE("Test allocation tags", "[allocation_tracking]") {
+	allocation_tag& tag = allocation_tag_named("test: tags");
+	CHECK(&tag == &allocation_tag_named("test: tags"));
+
+	tag.on_alloc(100);
+	tag.on_alloc(50);
+	tag.on_free(100);
+
+	auto stats = _find("test: tags");
+	CHECK(stats.live_bytes == 50);
+	CHECK(stats.peak_bytes == 150);
+	CHECK(stats.live_allocations == 1);
+	CHECK(stats.total_allocations == 2);
+
+	reset_allocation_peaks();
+	CHECK(_find("test: tags").peak_bytes == 50);
+
+	std::ostringstream out;
+	print_allocation_report(out);
+	CHECK(out.str().find("test: tags") != std::string::npos);
+
+	tag.on_free(50);
+}
+
+TEST_CASE("Test type names of allocation tags", "[allocation_tracking]") {
+	CHECK(allocation_tag_of<tracked_widget>().name().find("tracked_widget") != std::string::npos);
+}
+
+// Needs the library and tests built with STX_ALLOC_TRACKING, e.g. the tracking configuration in premake5.lua
+#if STX_ALLOC_TRACKING
+
+TEST_CASE("Test allocation tracking hooks", "[allocation_tracking]") {
+	SECTION("arena_allocator") {
+		allocation_tag& tag = allocation_tag_named("test: arena");
+		{
+			arena_allocator arena(1000);
+			arena.track_as(tag);
+			arena.alloc(10);
+			arena.alloc(5000);
+			CHECK(tag.stats().live_allocations == 2);
+			CHECK(tag.stats().live_bytes >= 6000);
+		}
+		CHECK(tag.stats().live_bytes == 0);
+	}
+
+	SECTION("make_shared") {
+		allocation_tag& tag = allocation_tag_of<tracked_widget>();
+		size_t before = tag.stats().live_bytes;
+		{
+			auto p = make_shared<tracked_widget>();
+			CHECK(tag.stats().live_bytes > before + sizeof(tracked_widget) - 1);
+		}
+		CHECK(tag.stats().live_bytes == before);
+	}
+
+	SECTION("object pools") {
+		allocation_tag& tag = allocation_tag_named("stx::object_pool<32>");
+		allocation_tag& big = allocation_tag_named("stx::object_pool<big>");
+		size_t before     = tag.stats().live_allocations;
+		size_t big_before = big.stats().live_bytes;
+
+		void* p = pool_alloc(30);
+		void* q = pool_alloc(100000);
+		CHECK(tag.stats().live_allocations == before + 1);
+		CHECK(big.stats().live_bytes == big_before + 100000);
+		pool_free(p, 30);
+		pool_free(q, 100000);
+		CHECK(tag.stats().live_allocations == before);
+		CHECK(big.stats().live_bytes == big_before);
+	}
+}
+
+#endif // STX_ALLOC_TRACKING
@@ -1 +1,250 @@
-// TODO
+#include "catch.hpp"
+
+#include <stx/allocator.hpp>
+using namespace stx;
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+TEST_CASE("Test arena_allocator", "[allocator]") {
+	arena_allocator arena(64);
+
+	SECTION("Allocations are contiguous within a block") {
+		char* a = arena.alloc(16);
+		char* b = arena.alloc(16);
+		CHECK(b == a + 16);
+
+		char* s = arena.alloc_string(5);
+		CHECK(s[5] == '\0');
+	}
+
+	SECTION("Big allocations get their own block") {
+		char* a   = arena.alloc(16);
+		char* big = arena.alloc(1000);
+		std::memset(big, 1, 1000);
+		char* b   = arena.alloc(16);
+		CHECK(b == a + 16);
+	}
+
+	SECTION("Blocks are reused after reset()") {
+		char* first = arena.alloc(60);
+		arena.alloc(60);
+		arena.alloc(1000);
+		arena.reset();
+		CHECK(arena.alloc(60) == first);
+	}
+
+	SECTION("mark() and rewind()") {
+		arena.alloc(10);
+		auto m = arena.mark();
+		char* a = arena.alloc(20);
+		arena.alloc(60);   // Next block
+		arena.alloc(1000); // Own block
+		arena.rewind(m);
+		CHECK(arena.alloc(20) == a);
+
+		{
+			arena_scope scope(arena);
+			arena.alloc(30);
+		}
+		CHECK(arena.alloc(4) == a + 20);
+	}
+
+	SECTION("undo_alloc()") {
+		char* a = arena.alloc(16);
+		arena.alloc(16);
+		arena.undo_alloc(16);
+		CHECK(arena.alloc(16) == a + 16);
+
+		arena.alloc(1000);
+		arena.undo_alloc(1000);
+		CHECK(arena.alloc(8) == a + 32);
+	}
+
+	SECTION("create() gives the memory back if the constructor throws") {
+		struct throws { throws(int) { throw std::runtime_error("nope"); } };
+
+		char* a = arena.alloc(8);
+		CHECK_THROWS(arena.create<throws>(1));
+		CHECK(arena.alloc(8) == a + 8);
+	}
+
+	SECTION("Moving") {
+		char* a = arena.alloc(16);
+		arena_allocator other = std::move(arena);
+		CHECK(other.alloc(16) == a + 16);
+		arena = std::move(other);
+		CHECK(arena.alloc(16) == a + 32);
+	}
+
+	SECTION("adopt()") {
+		char* a = arena.alloc(16);
+
+		arena_allocator other(128);
+		char* b = other.alloc(100);
+		char* c = other.alloc(100);
+		char* big = other.alloc(1000);
+		std::memset(b, 1, 100);
+		std::memset(c, 2, 100);
+		std::memset(big, 3, 1000);
+
+		arena.adopt(std::move(other));
+		CHECK(arena.alloc(16) == a + 16); // Keeps allocating from its own block
+		CHECK(b[99] == 1);
+		CHECK(c[99] == 2);
+		CHECK(big[999] == 3);
+
+		CHECK(other.alloc(16) != nullptr); // Usable again
+	}
+
+	SECTION("Thread local arenas") {
+		arena_allocator* main_arena = &thread_arena();
+		arena_allocator* other_arena = nullptr;
+		std::thread([&]() { other_arena = &thread_arena(); }).join();
+		CHECK(main_arena == &thread_arena());
+		CHECK(main_arena != other_arena);
+	}
+}
+
+TEST_CASE("Test aligned arena allocations", "[allocator]") {
+	arena_allocator arena(64);
+
+	arena.alloc(3);
+	char* a = arena.alloc(8, 8);
+	CHECK(uintptr_t(a) % 8 == 0);
+	CHECK(uintptr_t(arena.alloc(1, 32)) % 32 == 0);
+	CHECK(uintptr_t(arena.alloc(200, 64)) % 64 == 0); // Own block
+
+	struct alignas(16) vec4 { float x, y, z, w; };
+	arena.alloc(1);
+	CHECK(uintptr_t(arena.create<vec4>()) % 16 == 0);
+
+	SECTION("Padding past the end of a block starts a new one") {
+		arena.reset();
+		arena.alloc(60);
+		char* p = arena.alloc(8, 16);
+		CHECK(uintptr_t(p) % 16 == 0);
+		CHECK(arena.alloc(1) == p + 8);
+	}
+
+	SECTION("free_if_last()") {
+		arena.reset();
+		char* p = arena.alloc(16);
+		char* q = arena.alloc(16);
+		CHECK_FALSE(arena.free_if_last(p, 16));
+		CHECK(arena.free_if_last(q, 16));
+		CHECK(arena.alloc(16) == q);
+	}
+}
+
+TEST_CASE("Test arena_stl_allocator", "[allocator]") {
+	arena_allocator arena;
+
+	std::vector<int, arena_stl_allocator<int>> v{arena_stl_allocator<int>(arena)};
+	for(int i = 0; i < 1000; i++) v.push_back(i);
+	CHECK(v[999] == 999);
+	CHECK(uintptr_t(v.data()) % alignof(int) == 0);
+
+	using map_allocator = arena_stl_allocator<std::pair<const int, double>>;
+	std::map<int, double, std::less<int>, map_allocator> m{map_allocator(arena)};
+	m[1] = 1.5;
+	m[2] = 2.5;
+	CHECK(m.at(2) == 2.5);
+
+	// Rebinding keeps the arena
+	arena_stl_allocator<char> c(v.get_allocator());
+	CHECK(&c.arena() == &arena);
+	CHECK(c == v.get_allocator());
+
+	arena_allocator other;
+	CHECK(arena_stl_allocator<int>(other) != v.get_allocator());
+}
+
+TEST_CASE("Test arena_memory_resource", "[allocator]") {
+	arena_allocator       arena;
+	arena_memory_resource resource(arena);
+
+	std::pmr::vector<std::pmr::string> strings(&resource);
+	for(int i = 0; i < 100; i++) {
+		strings.emplace_back("a string which is too long for the small string optimization");
+	}
+	CHECK(strings[99].get_allocator().resource() == &resource); // Propagated to the elements
+	CHECK(strings[99].size() == 60);
+
+	std::pmr::unordered_map<int, std::pmr::string> table(&resource);
+	table[1] = "one";
+	CHECK(table.at(1) == "one");
+
+	arena_memory_resource same(arena);
+	CHECK(resource.is_equal(same));
+	CHECK_FALSE(resource.is_equal(*std::pmr::new_delete_resource()));
+}
+
+TEST_CASE("Test ring_allocator", "[allocator]") {
+	ring_allocator ring(1024, 2);
+
+	SECTION("Allocations are aligned and contiguous") {
+		char* a = ring.alloc(10, 1);
+		char* b = ring.alloc(6, 1);
+		CHECK(b == a + 10);
+		CHECK(uintptr_t(ring.alloc(8, 16)) % 16 == 0);
+		CHECK(uintptr_t(ring.create<double>(1.5)) % alignof(double) == 0);
+	}
+
+	SECTION("Frames are retired frames_in_flight frames later") {
+		char* first = ring.alloc(600, 1);
+		REQUIRE(first);
+		ring.next_frame();
+		CHECK(ring.used() == 600);
+		CHECK(ring.alloc(600, 1) == nullptr); // First frame is still in flight
+		CHECK(ring.overflowed());
+
+		char* second = ring.alloc(400, 1);
+		CHECK(second == first + 600);
+		ring.next_frame();
+		CHECK(ring.used() == 400); // First frame retired
+
+		// Wraps around, skipping the 24 bytes at the end
+		CHECK(ring.alloc(500, 1) == first);
+		CHECK(ring.used() == 400 + 24 + 500);
+		CHECK(ring.alloc(200, 1) == nullptr); // Would run into the second frame
+	}
+
+	SECTION("Statistics") {
+		ring.alloc(100, 1);
+		ring.alloc(200, 1);
+		ring.next_frame();
+		ring.alloc(50, 1);
+		ring.next_frame();
+		ring.next_frame();
+
+		auto stats = ring.stats();
+		CHECK(stats.capacity == 1024);
+		CHECK(stats.used == 0);
+		CHECK(stats.high_water_mark == 350);
+		CHECK(stats.peak_frame_bytes == 300);
+		CHECK(stats.frame_bytes == 0);
+		CHECK(stats.overflows == 0);
+
+		ring.alloc(2000, 1);
+		CHECK(ring.stats().overflows == 1);
+		ring.reset_stats();
+		CHECK(ring.stats().overflows == 0);
+		CHECK(ring.stats().high_water_mark == 0);
+	}
+
+	SECTION("A single frame in flight reuses everything every frame") {
+		ring_allocator single(256, 1);
+		char* a = single.alloc(200, 1);
+		single.next_frame();
+		CHECK(single.alloc(200, 1) == a);
+		CHECK(single.used() == 56 + 200); // Including the skipped end of the buffer
+	}
+}
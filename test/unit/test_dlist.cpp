@@ -37,4 +37,15 @@ TEST_CASE("Test dlist", "[dlist]") {
 	CHECK(c.next() == &d);
 	CHECK(d.prev() == &c);
 	CHECK(c.prev() == &a);
+
+	// Joining lists which were built separately
+	c.remove();
+	d.remove();
+	b.insert_next(&d);
+	a.append_list(&b);
+
+	CHECK(a.next() == &b);
+	CHECK(b.prev() == &a);
+	CHECK(b.next() == &d);
+	CHECK(d.prev() == &b);
 }
@@ -0,0 +1,41 @@
+#include "catch.hpp"
+
+#include <stx/mapped_file.hpp>
+using namespace stx;
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+static
+std::string write_temp_file(std::string const& content) {
+	std::string path = "/tmp/stx_test_mapped_file.txt";
+	FILE* file = std::fopen(path.c_str(), "wb");
+	REQUIRE(file);
+	std::fwrite(content.data(), 1, content.size(), file);
+	std::fclose(file);
+	return path;
+}
+
+TEST_CASE("Test mapped_file", "[mapped_file]") {
+	for(bool map : { true, false }) {
+		// Sizes around page boundaries: The terminator has to come from somewhere
+		for(size_t size : { size_t(0), size_t(1), size_t(4095), size_t(4096), size_t(8192), size_t(10000) }) {
+			std::string content(size, 'x');
+			if(size > 0) content.back() = 'y';
+
+			std::string path = write_temp_file(content);
+			mapped_file file(path.c_str(), map);
+			CHECK(file.size() == size);
+			CHECK(file.view() == content);
+			CHECK(file.c_str()[size] == '\0');
+
+			mapped_file moved = std::move(file);
+			CHECK(moved.view() == content);
+			CHECK(file.size() == 0);
+			std::remove(path.c_str());
+		}
+	}
+
+	CHECK_THROWS_AS(mapped_file("/nonexistent/stx/file"), std::runtime_error);
+}
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+
+#include <stx/object_pool.hpp>
+#include <stx/shared.hpp>
+#include <stx/event.hpp>
+using namespace stx;
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct pooled_point {
+	int x, y;
+	pooled_point(int x, int y) : x(x), y(y) {}
+};
+
+} // namespace
+
+template<>
+struct stx::use_object_pool<pooled_point> : std::true_type {};
+
+TEST_CASE("Test object pools", "[object_pool]") {
+	SECTION("Freed memory is reused") {
+		void* a = pool_alloc(24);
+		pool_free(a, 24);
+		CHECK(pool_alloc(24) == a);
+		pool_free(a, 24);
+	}
+
+	SECTION("Allocations are distinct and aligned") {
+		std::vector<void*> pointers;
+		for(int i = 0; i < 10000; i++) {
+			pointers.push_back(pool_alloc(48));
+		}
+		CHECK(std::set<void*>(pointers.begin(), pointers.end()).size() == pointers.size());
+		for(void* p : pointers) {
+			CHECK(uintptr_t(p) % object_pool_alignment == 0);
+			pool_free(p, 48);
+		}
+	}
+
+	SECTION("Big allocations") {
+		void* p = pool_alloc(object_pool_max_size + 1);
+		pool_free(p, object_pool_max_size + 1);
+	}
+
+	SECTION("pool_new and pool_delete") {
+		pooled_point* p = pool_new<pooled_point>(1, 2);
+		CHECK(p->y == 2);
+		pool_delete(p);
+	}
+
+	SECTION("Frees from other threads come back to the owner") {
+		std::vector<void*> pointers;
+		for(int i = 0; i < 1000; i++) {
+			pointers.push_back(pool_alloc(80));
+		}
+		std::thread([&]() {
+			for(void* p : pointers) pool_free(p, 80);
+		}).join();
+
+		std::set<void*> freed(pointers.begin(), pointers.end());
+		size_t reused = 0;
+		for(int i = 0; i < 1000; i++) {
+			void* p = pool_alloc(80);
+			reused += freed.count(p);
+			pointers[i] = p;
+		}
+		CHECK(reused > 0);
+		for(void* p : pointers) pool_free(p, 80);
+	}
+
+	SECTION("Slabs of exited threads are adopted") {
+		std::vector<void*> pointers;
+		std::thread([&]() {
+			for(int i = 0; i < 100; i++) pointers.push_back(pool_alloc(112));
+		}).join();
+
+		for(void* p : pointers) pool_free(p, 112);
+		std::thread([&]() {
+			std::set<void*> freed(pointers.begin(), pointers.end());
+			void* p = pool_alloc(112);
+			CHECK(freed.count(p) == 1);
+			pool_free(p, 112);
+		}).join();
+	}
+
+	SECTION("Producer and consumer threads") {
+		constexpr int num_objects = 20000;
+		std::vector<std::atomic<int*>> slots(num_objects);
+
+		std::thread producer([&]() {
+			for(int i = 0; i < num_objects; i++) {
+				slots[i] = pool_new<int>(i);
+			}
+		});
+		std::thread consumer([&]() {
+			for(int i = 0; i < num_objects; i++) {
+				int* p;
+				while(!(p = slots[i].load()));
+				CHECK(*p == i);
+				pool_delete(p);
+			}
+		});
+		producer.join();
+		consumer.join();
+	}
+}
+
+TEST_CASE("Test object pool hooks", "[object_pool]") {
+	SECTION("make_shared with use_object_pool") {
+		constexpr size_t block_size = sizeof(default_shared_block<pooled_point>);
+		char* probe = (char*) pool_alloc(block_size);
+		pool_free(probe, block_size);
+
+		shared<pooled_point> p = make_shared<pooled_point>(3, 4);
+		CHECK(p->x == 3);
+		CHECK((char*) p.get() >= probe);
+		CHECK((char*) p.get() <  probe + block_size);
+		weak<pooled_point> w = p;
+		p.reset();
+		CHECK(!w.lock());
+	}
+
+	SECTION("event::add") {
+		event<int> e;
+		int sum = 0;
+		for(int i = 0; i < 100; i++) {
+			e.add([&](int x) { sum += x; });
+		}
+		e(2);
+		CHECK(sum == 200);
+		e.clear();
+	}
+}
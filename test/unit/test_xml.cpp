@@ -1,6 +1,13 @@
 #include "catch.hpp"
 
 #include <stx/xml.hpp>
+#include <stx/xml.scan.hpp>
+#include <stx/async/threadpool.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace stx;
 using namespace stx::xml;
@@ -108,3 +115,315 @@ TEST_CASE("Test nasty text in xml") {
 	REQUIRE(frag->children()->type() == node::content);
 	REQUIRE(frag->children()->content_value().find("random < .5") != std::string_view::npos);
 }
+
+TEST_CASE("Test vectorized xml scanning", "[xml]") {
+	using namespace stx::xml::detail;
+	scan_isa best = best_scan_isa();
+
+	SECTION("Every scanner agrees with the scalar one at every alignment") {
+		// Long enough to span several 32 byte blocks, with bytes >= 128 and the interesting characters
+		std::string text = "  \t\n  some_long-name.with:colons\xC3\xA4>'quoted \"text\"'/=&amp;\x7F  <tag attr=\"value\"/>  ";
+		text += std::string(70, ' ') + "x";
+
+		for(size_t start = 0; start < 40; start++) {
+			const char* s = text.c_str() + start;
+			for(char c : { '<', '>', '"', '\'', '&', '\0' }) {
+				use_scan_isa(scan_isa::scalar);
+				const char* expected_char = find_char(s, c);
+				const char* expected_ws   = skip_whitespace(s);
+				const char* expected_name = scan_name(s);
+				const char* expected_pair = find_char(s, '&', '/');
+
+				for(auto isa : { scan_isa::sse2, scan_isa::avx2 }) {
+					if(!use_scan_isa(isa)) continue;
+					CHECK(find_char(s, c) == expected_char);
+					CHECK(skip_whitespace(s) == expected_ws);
+					CHECK(scan_name(s) == expected_name);
+					CHECK(find_char(s, '&', '/') == expected_pair);
+				}
+			}
+
+			// Bounded, so check every end too
+			for(const char* end = s; end <= text.c_str() + text.size(); end++) {
+				use_scan_isa(scan_isa::scalar);
+				const char* expected_escape = find_escape(s, end);
+				for(auto isa : { scan_isa::sse2, scan_isa::avx2 }) {
+					if(!use_scan_isa(isa)) continue;
+					CHECK(find_escape(s, end) == expected_escape);
+				}
+			}
+		}
+	}
+
+	SECTION("The DOM doesn't depend on the scanner") {
+		const char* source = R"(
+			<?xml version="1.0"?>
+			<root>
+				<!-- a - comment -- with dashes -->
+				<a_rather_long_element_name_exceeding_thirty_two_bytes key='single' other="double">
+					Content with < spaces and a tab <	and more
+				</a_rather_long_element_name_exceeding_thirty_two_bytes>
+				<empty/>
+			</root>
+		)";
+
+		std::string expected;
+		for(auto isa : { scan_isa::scalar, scan_isa::sse2, scan_isa::avx2 }) {
+			if(!use_scan_isa(isa)) continue;
+
+			node doc;
+			arena_allocator alloc;
+			doc.parse_document(alloc, source);
+
+			std::ostringstream out;
+			for(node* n = doc.children(); n; n = n->next()) n->print(out);
+			if(expected.empty()) expected = out.str();
+			CHECK(out.str() == expected);
+		}
+		CHECK(expected.find("a_rather_long_element_name_exceeding_thirty_two_bytes") != std::string::npos);
+		CHECK(expected.find("Content with &lt; spaces and a tab &lt;\tand more") != std::string::npos);
+	}
+
+	use_scan_isa(best);
+}
+
+TEST_CASE("Test loading xml files", "[xml]") {
+	// Exactly one page, so the terminator of the mapping comes from the extra page
+	std::string text = "<root><child name='value'>content</child></root>";
+	text.resize(4096, ' ');
+
+	std::string path = "/tmp/stx_test_xml_load.xml";
+	FILE* file = std::fopen(path.c_str(), "wb");
+	REQUIRE(file);
+	std::fwrite(text.data(), 1, text.size(), file);
+	std::fclose(file);
+
+	for(bool map : { true, false }) {
+		document doc = document::load(path.c_str(), map);
+		CHECK(doc.source.mapped() == map);
+
+		node& child = doc.req_child("root").req_child("child");
+		CHECK(child.req_attrib("name").value() == "value");
+		CHECK(child.children()->content_value() == "content");
+
+		// Views point straight into the source, which the document keeps alive
+		const char* begin = doc.source.c_str();
+		CHECK(child.name().data() >= begin);
+		CHECK(child.name().data() <  begin + doc.source.size());
+	}
+
+	document constructed{path};
+	CHECK(constructed.child("root"));
+
+	std::remove(path.c_str());
+}
+
+// Same structure, and all views point to the same parts of the text
+static
+void check_same_tree(node* a, node* b, node* parent_a, node* parent_b) {
+	node* prev_b = nullptr;
+	for(; a && b; a = a->next(), b = b->next()) {
+		REQUIRE(a->type() == b->type());
+		CHECK(a->parent() == parent_a);
+		CHECK(b->parent() == parent_b);
+		CHECK(b->prev() == prev_b);
+		if(a->type() == node::regular) {
+			CHECK(a->name().data() == b->name().data());
+			CHECK(a->name() == b->name());
+
+			attribute* atb_a = a->attributes();
+			attribute* atb_b = b->attributes();
+			for(; atb_a && atb_b; atb_a = atb_a->next(), atb_b = atb_b->next()) {
+				CHECK(atb_a->name().data() == atb_b->name().data());
+				CHECK(atb_a->value() == atb_b->value());
+			}
+			CHECK(atb_a == atb_b); // Both nullptr
+		}
+		else if(a->type() == node::content) {
+			CHECK(a->content_value().data() == b->content_value().data());
+			CHECK(a->content_value() == b->content_value());
+		}
+		check_same_tree(a->children(), b->children(), a, b);
+		prev_b = b;
+	}
+	CHECK(a == b); // Both nullptr
+}
+
+TEST_CASE("Test parallel xml parsing", "[xml]") {
+	threadpool pool(4);
+
+	auto check_same_document = [&](std::string const& text) {
+		document serial = document::parse(text.c_str());
+		for(size_t num_chunks : { 2, 3, 8 }) {
+			document parallel = document::parse(text.c_str(), pool, num_chunks);
+			check_same_tree(serial.children(), parallel.children(), &serial, &parallel);
+		}
+	};
+
+	auto entries = [](size_t min_size, std::string const& entry) {
+		std::string result;
+		for(int i = 0; result.size() < min_size; i++) {
+			result += "<entry id='" + std::to_string(i) + "'>" + entry + "</entry>\n";
+		}
+		return result;
+	};
+	const size_t big = 4 * document::parallel_min_chunk_size;
+
+	SECTION("Many small children of the root element") {
+		check_same_document(
+			"<?xml version='1.0'?>\n<!-- Before the root -->\n<feed>\n" +
+			entries(big, "<title>Some title</title> text <empty/>") +
+			"</feed>\n<!-- After the root -->\n"
+		);
+	}
+
+	SECTION("Chunks starting in the middle of a child are parsed again") {
+		check_same_document("<root><a>" + entries(big, "<b>x</b>") + "</a><c/></root>");
+	}
+
+	SECTION("Tags in comments and text") {
+		std::string entry = "<!-- <fake attribute='x'> --> text < with <inner/> tags";
+		check_same_document("<root>" + entries(big, entry) + "</root><!-- <trailing> -->");
+	}
+
+	SECTION("Errors are reported") {
+		std::string text = "<root>" + entries(big, "<a></a>") + "<broken attribute='></root>";
+		CHECK_THROWS_AS(document::parse(text.c_str(), pool, 4), errors::parsing_error);
+
+		std::string mismatched = "<root>" + entries(big, "<a></a>") + "<a></b></root>";
+		CHECK_THROWS_AS(document::parse(mismatched.c_str(), pool, 4), errors::parsing_error);
+	}
+
+	SECTION("Small documents are parsed serially") {
+		check_same_document("<root><a/><b/></root>");
+	}
+}
+
+TEST_CASE("Test xml name index", "[xml]") {
+	std::string text = "<root>";
+	for(int i = 0; i < 200; i++) {
+		std::string name = "item" + std::to_string(i % 7);
+		text += "<" + name + " n='" + std::to_string(i) + "' a" + std::to_string(i % 3) + "='x'/>";
+		if(i % 5 == 0) text += "text<!-- comment -->";
+	}
+	text += "</root>";
+
+	// Many attributes on a node with few children
+	text += "<attributes";
+	for(int i = 0; i < 40; i++) text += " attr" + std::to_string(i) + "='" + std::to_string(i) + "'";
+	text += " attr0='duplicate'/>";
+
+	document plain   = document::parse(text.c_str());
+	document indexed = document::parse(text.c_str());
+	indexed.enable_index(16);
+
+	node& plain_root   = plain.req_child("root");
+	node& indexed_root = indexed.req_child("root");
+	CHECK(plain_root.index() == nullptr);
+	CHECK(indexed_root.index() != nullptr);
+	CHECK(indexed_root.children()->index() == nullptr); // Too small
+
+	auto names = { "item0", "item3", "item6", "missing" };
+
+	SECTION("Lookups find the same nodes") {
+		for(auto name : names) {
+			node* a = plain_root.child(name);
+			node* b = indexed_root.child(name);
+			while(a && b) {
+				CHECK(a->name() == b->name());
+				CHECK(a->attrib<int>("n", -1) == b->attrib<int>("n", -1));
+				node* prev_a = a->prev(name);
+				node* prev_b = b->prev(name);
+				CHECK((prev_a ? prev_a->name().data() : nullptr) == (prev_b ? prev_b->name().data() : nullptr));
+				a = a->next(name);
+				b = b->next(name);
+			}
+			CHECK(a == nullptr);
+			CHECK(b == nullptr);
+		}
+
+		// Starting from nodes of another name and type
+		node* a = plain_root.children();
+		node* b = indexed_root.children();
+		for(; a && b; a = a->next(), b = b->next()) {
+			for(auto name : names) {
+				node* first_a = a->first(name);
+				node* first_b = b->first(name);
+				CHECK((first_a ? first_a->name().data() : nullptr) == (first_b ? first_b->name().data() : nullptr));
+				node* next_a = a->next(name);
+				node* next_b = b->next(name);
+				CHECK((next_a ? next_a->name().data() : nullptr) == (next_b ? next_b->name().data() : nullptr));
+			}
+		}
+	}
+
+	SECTION("Attributes") {
+		node& attributes = indexed.req_child("attributes");
+		REQUIRE(attributes.index() != nullptr);
+		CHECK(attributes.req_attrib<int>("attr39") == 39);
+		CHECK(attributes.attrib("attr0")->value() == "0"); // The first one wins, like without the index
+		CHECK(attributes.attrib("attr40") == nullptr);
+	}
+
+	SECTION("Moving the document after enable_index") {
+		document moved_from;
+		moved_from = document::parse(text.c_str());
+		moved_from.enable_index(16);
+
+		std::vector<document> documents;
+		documents.push_back(std::move(moved_from));
+		documents.emplace_back(); // Moves the first document again
+		document& doc = documents.front();
+
+		node& root = doc.req_child("root");
+		CHECK(root.parent() == &doc);
+		REQUIRE(root.index() != nullptr);
+		CHECK(root.child("item3")->attrib<int>("n", -1) == 3);
+		CHECK(moved_from.children() == nullptr);
+		CHECK(moved_from.allocator.mark().top == nullptr); // The index was built in doc's allocator
+	}
+}
+
+TEST_CASE("Test xml entity decoding", "[xml]") {
+	const char* source =
+		"<root plain='no references' escaped='a &lt; b &amp;&amp; &quot;c&quot; &apos;d&apos; &gt; e'"
+		" chars='&#65;&#x42;&#xe9;&#x20AC;&#128512;' unknown='AT&T &nbsp; &#0; &#xD800; &#x110000; &#; &#x; &amp'"
+		" spaces='line&#10;break\tand\r\nlines'>"
+		"Tom &amp; Jerry\r\nsecond line\rthird line"
+		"<plain>Nothing to decode here</plain>"
+		"</root>";
+	document doc = document::parse(source);
+	node& root = doc.req_child("root");
+
+	SECTION("Attributes") {
+		CHECK(root.req_attrib("escaped").decoded_value(doc.allocator) == "a < b && \"c\" 'd' > e");
+		CHECK(root.req_attrib("chars").decoded_value(doc.allocator) == "AB\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+		CHECK(root.req_attrib("unknown").decoded_value(doc.allocator) == "AT&T &nbsp; &#0; &#xD800; &#x110000; &#; &#x; &amp");
+		// Literal whitespace is normalized, character references aren't
+		CHECK(root.req_attrib("spaces").decoded_value(doc.allocator) == "line\nbreak and lines");
+
+		// The raw text stays available
+		CHECK(root.req_attrib("escaped").value() == "a &lt; b &amp;&amp; &quot;c&quot; &apos;d&apos; &gt; e");
+		CHECK(root.req_attrib<std::string>("escaped") == "a < b && \"c\" 'd' > e");
+	}
+
+	SECTION("Nothing to decode returns the raw text") {
+		attribute& plain = root.req_attrib("plain");
+		CHECK(plain.decoded_value(doc.allocator).data() == plain.value().data());
+
+		node& content = *root.req_child("plain").children();
+		CHECK(content.decoded_content(doc.allocator).data() == content.content_value().data());
+	}
+
+	SECTION("Decoded once") {
+		attribute& escaped = root.req_attrib("escaped");
+		std::string_view first = escaped.decoded_value(doc.allocator);
+		CHECK(first.data() != escaped.value().data());
+		CHECK(escaped.decoded_value(doc.allocator).data() == first.data());
+
+		node& content = *root.children();
+		REQUIRE(content.type() == node::content);
+		CHECK(content.decoded_content(doc.allocator) == "Tom & Jerry\nsecond line\nthird line");
+		CHECK(content.decoded_content(doc.allocator).data() == content.decoded_content(doc.allocator).data());
+	}
+}
@@ -0,0 +1,115 @@
+#include "catch.hpp"
+
+#include <stx/xml.hpp>
+#include <stx/xml.pull.hpp>
+
+using namespace stx;
+using namespace stx::xml;
+
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* source = R"(
+	<?xml version="1.0" encoding="UTF-8"?>
+	<!DOCTYPE feed>
+	<feed version='2'>
+		<!-- A comment -- with dashes -->
+		<entry id="1" flag>
+			<title>First entry</title>
+			<empty/>
+			Some text with a < which isn't a tag
+		</entry>
+		<entry id='2'><title>Second</title></entry>
+	</feed>
+)";
+
+/// Events as strings, from the DOM
+void dom_events(node& n, std::vector<std::string>& out) {
+	switch(n.type()) {
+		case node::regular:
+			out.push_back("start " + std::string(n.name()));
+			for(auto* a = n.attributes(); a; a = a->next()) {
+				out.push_back("attribute " + std::string(a->name()) + "=" + std::string(a->value()));
+			}
+			for(auto* c = n.children(); c; c = c->next()) dom_events(*c, out);
+			out.push_back("end " + std::string(n.name()));
+			break;
+		case node::content:
+			out.push_back("text " + std::string(n.content_value()));
+			break;
+		default: break;
+	}
+}
+
+std::vector<std::string> pull_events(pull_parser& parser) {
+	std::vector<std::string> out;
+	while(parser.next() != pull_parser::end_of_document) {
+		switch(parser.type()) {
+			case pull_parser::start_element: out.push_back("start " + std::string(parser.name())); break;
+			case pull_parser::attribute:     out.push_back("attribute " + std::string(parser.name()) + "=" + std::string(parser.value())); break;
+			case pull_parser::text:          out.push_back("text " + std::string(parser.value())); break;
+			case pull_parser::end_element:   out.push_back("end " + std::string(parser.name())); break;
+			default: break;
+		}
+	}
+	return out;
+}
+
+} // namespace
+
+TEST_CASE("Test xml pull_parser", "[xml]") {
+	document doc = document::parse(source);
+	std::vector<std::string> expected;
+	for(auto* n = doc.children(); n; n = n->next()) dom_events(*n, expected);
+	REQUIRE(expected.size() > 10);
+
+	SECTION("Same events as the DOM, no matter where chunks end") {
+		for(size_t chunk_size : { 1, 3, 7, 16, 64, 4096 }) {
+			pull_parser parser(pull_parser::read_string(source), chunk_size);
+			CHECK(pull_events(parser) == expected);
+		}
+	}
+
+	SECTION("Depth") {
+		pull_parser parser(pull_parser::read_string("<a><b/>text</a>"));
+		CHECK(parser.next() == pull_parser::start_element);
+		CHECK(parser.depth() == 1);
+		CHECK(parser.next() == pull_parser::start_element);
+		CHECK(parser.depth() == 2);
+		CHECK(parser.next() == pull_parser::end_element);
+		CHECK(parser.name() == "b");
+		CHECK(parser.depth() == 1);
+		CHECK(parser.next() == pull_parser::text);
+		CHECK(parser.value() == "text");
+		CHECK(parser.next() == pull_parser::end_element);
+		CHECK(parser.depth() == 0);
+		CHECK(parser.next() == pull_parser::end_of_document);
+	}
+
+	SECTION("The buffer only grows to fit single units") {
+		std::string big = "<list>";
+		for(int i = 0; i < 10000; i++) big += "<item value='" + std::to_string(i) + "'/>";
+		big += "</list>";
+
+		pull_parser parser(pull_parser::read_string(big), 256);
+		size_t items = 0;
+		while(parser.next() != pull_parser::end_of_document) {
+			if(parser.type() == pull_parser::start_element && parser.name() == "item") items++;
+		}
+		CHECK(items == 10000);
+		CHECK(parser.buffer_capacity() < 1024);
+	}
+
+	SECTION("Errors") {
+		pull_parser unclosed(pull_parser::read_string("<a><b></b>"));
+		CHECK_THROWS_AS(pull_events(unclosed), parsing::errors::parsing_error);
+
+		pull_parser mismatched(pull_parser::read_string("<a></b>"));
+		CHECK_THROWS_AS(pull_events(mismatched), parsing::errors::parsing_error);
+
+		pull_parser truncated(pull_parser::read_string("<a attr='value"));
+		CHECK_THROWS_AS(pull_events(truncated), parsing::errors::parsing_error);
+	}
+}
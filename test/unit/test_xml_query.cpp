@@ -0,0 +1,103 @@
+#include "catch.hpp"
+
+#include <stx/xml.hpp>
+#include <stx/xml.query.hpp>
+
+using namespace stx;
+using namespace stx::xml;
+
+#include <string>
+
+namespace {
+
+const char* source = R"(
+	<?xml version="1.0"?>
+	<feed>
+		<entry id='1' type='article'><title>A</title><author><name>X</name></author></entry>
+		<entry id='2' type="note"><title>B</title></entry>
+		text
+		<entry id='3' type='article'>
+			<title>C</title>
+			<entry id='3.1' type='article'><title>D</title></entry>
+		</entry>
+		<other><title>E</title></other>
+	</feed>
+)";
+
+/// ids or contents of all matches, comma separated
+std::string select(query const& q, node& context) {
+	std::string result;
+	q.each(context, [&](node& n) {
+		if(!result.empty()) result += ",";
+		if(auto* id = n.attrib("id")) result += std::string(id->value());
+		else if(n.children() && n.children()->type() == node::content) result += std::string(n.children()->content_value());
+		else result += std::string(n.name());
+	});
+	return result;
+}
+
+} // namespace
+
+TEST_CASE("Test xml query", "[xml]") {
+	document plain   = document::parse(source);
+	document indexed = document::parse(source);
+	indexed.enable_index(1);
+
+	for(document* doc : { &plain, &indexed }) {
+		node& feed = doc->req_child("feed");
+
+		CHECK(select(query("/feed/entry"), *doc) == "1,2,3");
+		CHECK(select(query("/feed/entry"), feed) == "1,2,3"); // Absolute paths start at the document
+		CHECK(select(query("entry"), feed) == "1,2,3");
+		CHECK(select(query("feed/*"), *doc) == "1,2,3,other");
+		CHECK(select(query("feed/*[@id]"), *doc) == "1,2,3");
+
+		// Predicates apply in order
+		CHECK(select(query("/feed/entry[@type='article']/title"), *doc) == "A,C");
+		CHECK(select(query("/feed/entry[@type=\"article\"][2]"), *doc) == "3");
+		CHECK(select(query("/feed/entry[2][@type='article']"), *doc) == "");
+		CHECK(select(query("/feed/entry[ 2 ]"), *doc) == "2");
+		CHECK(select(query("/feed/entry[4]"), *doc) == "");
+
+		// Descendants
+		CHECK(select(query("//title"), *doc) == "A,B,C,D,E");
+		CHECK(select(query("//entry//title"), *doc) == "A,B,C,D");
+		CHECK(select(query("//entry/./title"), *doc) == "A,B,C,D");
+		CHECK(select(query("//entry[1]"), *doc) == "1,3.1"); // Position among siblings
+		CHECK(select(query(".//name"), feed) == "X");
+		CHECK(select(query("//missing"), *doc) == "");
+
+		query entries("//entry");
+		CHECK(entries.count(*doc) == 4);
+		CHECK(entries.first(*doc)->req_attrib("id").value() == "1");
+
+		size_t visited = 0;
+		entries.each(*doc, [&](node&) { return ++visited < 2; });
+		CHECK(visited == 2);
+	}
+
+	SECTION("Nested matches in document order and without duplicates") {
+		for(bool index : { false, true }) {
+			document nested = document::parse("<r><a><x><a><b><c id='1'/></b></a></x><b><c id='2'/></b></a></r>");
+			if(index) nested.enable_index(1);
+			CHECK(select(query("//a/b/c"), nested) == "1,2");
+			CHECK(select(query("//a/b//c"), nested) == "1,2");
+			CHECK(select(query("//a//c"), nested) == "1,2");
+			CHECK(select(query("//x//b/c"), nested) == "1");
+
+			document repeated = document::parse("<r><a><b><a><b><c/></b></a></b></a></r>");
+			if(index) repeated.enable_index(1);
+			CHECK(query("//a/b//c").count(repeated) == 1);
+			CHECK(query("//a//a//c").count(repeated) == 1);
+			CHECK(query("//b").count(repeated) == 2);
+			CHECK(query("//a/b[1]/a/b").count(repeated) == 1);
+		}
+	}
+
+	SECTION("Unsupported expressions") {
+		for(auto expression : { "", "/", "a/", "a[0]", "a[@x=v]", "a[@x='v'", "../a", "//.", "a[last()]", "a|b" }) {
+			CAPTURE(expression);
+			CHECK_THROWS_AS(query(expression), errors::parsing_error);
+		}
+	}
+}
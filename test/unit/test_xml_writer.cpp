@@ -0,0 +1,141 @@
+#include "catch.hpp"
+
+#include <stx/xml.hpp>
+#include <stx/xml.writer.hpp>
+#include <stx/file2vector.hpp>
+
+using namespace stx;
+using namespace stx::xml;
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char* source = R"(<?xml version="1.0"?>
+<!DOCTYPE feed>
+<feed version='2' flag>
+	<!-- A comment -->
+	<entry id="1" title='Say "hi" &amp; bye'>
+		<title>Fish &amp; chips &#x20; &#38; for 5 < 6</title>
+		<empty/>
+		Some text
+		<nested><deeper a=''/></nested>
+	</entry>
+</feed>
+)";
+
+/// Same structure and text
+void check_same(node* a, node* b) {
+	for(; a && b; a = a->next(), b = b->next()) {
+		REQUIRE(a->type() == b->type());
+		switch(a->type()) {
+			case node::regular:   CHECK(a->name() == b->name()); break;
+			case node::content:   CHECK(a->content_value() == b->content_value()); break;
+			case node::comment:   CHECK(a->comment_value() == b->comment_value()); break;
+			default: break;
+		}
+		attribute* atb_a = a->attributes();
+		attribute* atb_b = b->attributes();
+		for(; atb_a && atb_b; atb_a = atb_a->next(), atb_b = atb_b->next()) {
+			CHECK(atb_a->name() == atb_b->name());
+			CHECK(atb_a->value() == atb_b->value());
+		}
+		CHECK(atb_a == atb_b);
+		check_same(a->children(), b->children());
+	}
+	CHECK(a == b);
+}
+
+} // namespace
+
+TEST_CASE("Test xml writer", "[xml]") {
+	document doc = document::parse(source);
+
+	SECTION("Compact") {
+		writer out;
+		out.write(doc.req_child("feed").req_child("entry"));
+		CHECK(out.view() ==
+			"<entry id=\"1\" title=\"Say &quot;hi&quot; &amp; bye\">"
+			"<title>Fish &amp; chips &#x20; &#38; for 5 &lt; 6</title>"
+			"<empty/>"
+			"Some text"
+			"<nested><deeper a=\"\"/></nested>"
+			"</entry>"
+		);
+	}
+
+	SECTION("Pretty") {
+		writer out({ true, 1 });
+		out.write(doc.req_child("feed").req_child("entry").req_child("nested"));
+		out.write(doc.req_child("feed").req_child("entry").req_child("title"), 1);
+		CHECK(out.view() ==
+			"<nested>\n"
+			" <deeper a=\"\"/>\n"
+			"</nested>\n"
+			" <title>Fish &amp; chips &#x20; &#38; for 5 &lt; 6</title>\n"
+		);
+	}
+
+	SECTION("Reparsing gives the same document") {
+		// Text stays raw, so it only comes back the same if nothing in it needs escaping
+		const char* escaped = R"(<?xml version="1.0"?>
+			<feed version='2' flag>
+				<!-- A comment -->
+				<entry id="1" title='Say &quot;hi&quot; &amp; bye'>
+					<title>Fish &amp; chips</title>
+					<empty/>
+					Some text
+					<nested><deeper a=''/></nested>
+				</entry>
+			</feed>
+		)";
+		document original = document::parse(escaped);
+
+		for(bool pretty : { false, true }) {
+			writer out({ pretty });
+			out.write(original);
+			std::string text(out.view());
+			document reparsed = document::parse(text.c_str());
+			check_same(original.children(), reparsed.children());
+
+			CHECK(text.rfind("<?xml version=\"1.0\"?>", 0) == 0);
+			CHECK(text.find("<!--A comment-->") != std::string::npos);
+		}
+	}
+
+	SECTION("Arbitrary text is escaped completely") {
+		writer out;
+		out.text("a & b &amp; <c> \"d\"");
+		CHECK(out.view() == "a &amp; b &amp;amp; &lt;c&gt; \"d\"");
+	}
+
+	SECTION("Writing to a file descriptor") {
+		writer expected;
+		expected.write(doc);
+
+		std::string path = "/tmp/stx_test_xml_writer.xml";
+		int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		REQUIRE(fd >= 0);
+		{
+			writer out = writer::to_fd(fd, {}, 16); // Flushes all the time
+			out.write(doc);
+			out.flush();
+			CHECK(out.view().empty());
+		}
+		::close(fd);
+
+		CHECK(stx::file2string(path.c_str()) == expected.view());
+		std::remove(path.c_str());
+	}
+
+	SECTION("node::print() pretty prints") {
+		std::ostringstream stream;
+		doc.req_child("feed").req_child("entry").req_child("nested").print(stream);
+		CHECK(stream.str() == "<nested>\n  <deeper a=\"\"/>\n</nested>\n");
+	}
+}